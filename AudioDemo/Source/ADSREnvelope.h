@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef ADSRENVELOPE_H_INCLUDED
+#define ADSRENVELOPE_H_INCLUDED
+
+/* An attack-decay-sustain-release envelope that works a block at a time.
+
+   The attack is a linear ramp, and the decay and release are exponential
+   curves. Every segment's length in samples is worked out in closed form
+   when it starts, so the per-sample work is just filling in a ramp, with
+   no stage checks or threshold comparisons - and the exact sample where
+   the note finishes is known in advance.
+
+   Changes to the parameters take effect from the start of the next segment.
+*/
+class ADSREnvelope
+{
+public:
+    struct Parameters
+    {
+        float attackSeconds = 0.005f;
+        float decaySeconds = 0.05f;
+        float sustainLevel = 1.0f;
+        float releaseSeconds = 0.012f;    // (about the same as the old tailOff of 0.99 per sample at 44.1kHz)
+    };
+
+    ADSREnvelope()
+        : stage (Stage::idle), value (0), attackStep (0), target (0), coefficient (1.0f),
+          samplesLeftInStage (0), sampleRate (44100.0)
+    {
+    }
+
+    void setSampleRate (double newSampleRate) noexcept      { sampleRate = newSampleRate; }
+    void setParameters (const Parameters& newParameters) noexcept   { parameters = newParameters; }
+
+    //==========================================================================
+    /** Starts the attack from wherever the envelope is now. */
+    void noteOn() noexcept
+    {
+        noteOn (value);
+    }
+
+    /** Starts the attack from the given level (between 0 and 1), taking the same
+        proportion of the attack time that it's got left to climb. A voice that's
+        restarted while it's still sounding uses this, so that it doesn't click.
+    */
+    void noteOn (float startValue) noexcept
+    {
+        value = jlimit (0.0f, 1.0f, startValue);
+        const int attackSamples = secondsToSamples (parameters.attackSeconds);
+
+        stage = Stage::attack;
+        samplesLeftInStage = jmax (1, roundToInt (attackSamples * (1.0f - value)));
+        attackStep = (1.0f - value) / samplesLeftInStage;
+    }
+
+    void noteOff() noexcept
+    {
+        if (stage == Stage::idle || stage == Stage::release)
+            return;
+
+        // the release curve starts at 1.0 and takes releaseSeconds to get down to the
+        // threshold, so starting lower down the curve, it'll get there sooner
+        startExponential (Stage::release, 0.0f, parameters.releaseSeconds, 1.0f);
+    }
+
+    void reset() noexcept
+    {
+        stage = Stage::idle;
+        value = 0;
+    }
+
+    bool isActive() const noexcept          { return stage != Stage::idle; }
+    bool isInAttack() const noexcept        { return stage == Stage::attack; }
+
+    /** Returns the level that the envelope has reached at the end of the last block. */
+    float getCurrentValue() const noexcept  { return value; }
+
+    //==========================================================================
+    /** Writes the next numSamples of the envelope into dest. Returns the number of
+        samples before the release finished (which will be numSamples if it's still
+        going) - any samples after that point are set to zero.
+    */
+    int getNextBlock (float* dest, int numSamples) noexcept
+    {
+        int pos = 0;
+
+        while (pos < numSamples)
+        {
+            if (stage == Stage::idle)
+            {
+                FloatVectorOperations::clear (dest + pos, numSamples - pos);
+                return pos;
+            }
+
+            if (stage == Stage::sustain)
+            {
+                FloatVectorOperations::fill (dest + pos, value, numSamples - pos);
+                return numSamples;
+            }
+
+            const int num = jmin (numSamples - pos, samplesLeftInStage);
+
+            if (stage == Stage::attack)
+            {
+                for (int i = 0; i < num; ++i)
+                    dest[pos + i] = value + attackStep * (float) i;
+
+                value += attackStep * (float) num;
+            }
+            else
+            {
+                fillExponential (dest + pos, num, target, value - target, coefficient);
+                value = target + (value - target) * std::pow (coefficient, (float) num);
+            }
+
+            pos += num;
+            samplesLeftInStage -= num;
+
+            if (samplesLeftInStage == 0)
+                moveToNextStage();
+        }
+
+        return numSamples;
+    }
+
+private:
+    //==========================================================================
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    Stage stage;
+    Parameters parameters;
+    float value, attackStep, target, coefficient;
+    int samplesLeftInStage;
+    double sampleRate;
+
+    // how close a decay or release has to get to its target before it's finished
+    const float threshold = 0.005f;
+
+    int secondsToSamples (float seconds) const noexcept
+    {
+        return jmax (1, roundToInt (seconds * sampleRate));
+    }
+
+    void moveToNextStage() noexcept
+    {
+        switch (stage)
+        {
+            case Stage::attack:
+                value = 1.0f;
+
+                if (parameters.sustainLevel < 1.0f)
+                    startExponential (Stage::decay, parameters.sustainLevel, parameters.decaySeconds, 1.0f - parameters.sustainLevel);
+                else
+                    stage = Stage::sustain;
+
+                break;
+
+            case Stage::decay:
+                value = parameters.sustainLevel;
+                stage = Stage::sustain;
+                break;
+
+            case Stage::release:
+            default:
+                reset();
+                break;
+        }
+    }
+
+    // Starts a curve towards newTarget, which gets within threshold * fullDistance
+    // of it after the given time when it starts fullDistance away, and works out
+    // exactly how many samples it'll take from the current value.
+    void startExponential (Stage newStage, float newTarget, float seconds, float fullDistance) noexcept
+    {
+        stage = newStage;
+        target = newTarget;
+
+        const int fullLength = secondsToSamples (seconds);
+        coefficient = std::pow (threshold, 1.0f / fullLength);
+
+        const float distance = std::abs (value - target);
+        const float endDistance = threshold * fullDistance;
+
+        samplesLeftInStage = distance > endDistance
+                                ? jmax (1, (int) std::ceil (std::log (endDistance / distance) / std::log (coefficient)))
+                                : 1;
+    }
+
+    // dest[i] = offset + startDistance * coefficient^i. Four separate running
+    // products are used, so that the compiler can vectorise the loop.
+    static void fillExponential (float* dest, int num, float offset, float startDistance, float coeff) noexcept
+    {
+        float lanes[4];
+        lanes[0] = startDistance;
+
+        for (int k = 1; k < 4; ++k)
+            lanes[k] = lanes[k - 1] * coeff;
+
+        const float coeff2 = coeff * coeff;
+        const float coeff4 = coeff2 * coeff2;
+        int i = 0;
+
+        for (; i + 4 <= num; i += 4)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                dest[i + k] = offset + lanes[k];
+                lanes[k] *= coeff4;
+            }
+        }
+
+        for (int k = 0; i < num; ++i, ++k)
+            dest[i] = offset + lanes[k];
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ADSREnvelope)
+};
+
+
+#endif  // ADSRENVELOPE_H_INCLUDED
@@ -16,11 +16,27 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include <array>
+#include <atomic>
+#include <limits>
+#include <vector>
 
 struct ProjucerDemoClasses
 {
+    #include "../../Shared/AnimationScheduler.h"
+    #include "../../Shared/FrameTimingMonitor.h"
+    #include "../../Shared/ParameterStore.h"
+    #include "../../Shared/AnalysisBus.h"
+    #include "VoiceRenderPool.h"
+    #include "VoiceAllocator.h"
+    #include "ADSREnvelope.h"
+    #include "SmoothedValue.h"
+    #include "SineOscillator.h"
+    #include "Oversampler.h"
     #include "Synth.h"
+    #include "Sampler.h"
+    #include "SynthBenchmark.h"
     #include "Oscilloscope.h"
+    #include "SpectrumAnalyser.h"
     #include "MainComponent.h"
 };
 
@@ -46,7 +62,39 @@ public:
     //==============================================================================
     void initialise (const String& commandLine) override
     {
-        mainWindow = new MainWindow (getApplicationName());
+        // launch with --opengl to render the demo pages on an OpenGL thread. On Linux the
+        // GL context still needs an X display, so on a headless box run it under Xvfb, with
+        // LIBGL_ALWAYS_SOFTWARE=1 to make Mesa use its llvmpipe renderer - see the README
+        const bool useOpenGL = commandLine.contains ("--opengl");
+
+        // launch with --frame-stats to show the paint/timer stats of the animated
+        // components, and to log them as JSON when the app quits
+        const bool showFrameStats = commandLine.contains ("--frame-stats");
+
+        // launch with --parallel-voices to render the synth's voices on all the CPU cores
+        const int numVoiceRenderThreads = commandLine.contains ("--parallel-voices") ? SystemStats::getNumCpus() : 1;
+
+        // launch with --oversample=2, 4 or 8 to render the synth's voices at a higher sample rate
+        const int oversamplingFactor = getOversamplingFactor (commandLine);
+
+        // launch with --mpe to treat the MIDI input as an MPE zone
+        const bool useMPE = commandLine.contains ("--mpe");
+
+        // launch with --samples=<folder> to play a folder of WAV or AIFF files instead
+        // of the sine synth (see SamplerSynth::loadSamples() for how they're named)
+        const File sampleFolder (getSampleFolder());
+
+        // launch with --benchmark-oversampling to log how long the synth takes to
+        // render at each oversampling factor, and then quit
+        if (commandLine.contains ("--benchmark-oversampling"))
+        {
+            Logger::writeToLog (ProjucerDemoClasses::SynthBenchmark::runOversamplingBenchmark());
+            quit();
+            return;
+        }
+
+        mainWindow = new MainWindow (getApplicationName(), useOpenGL, showFrameStats,
+                                     numVoiceRenderThreads, oversamplingFactor, useMPE, sampleFolder);
     }
 
     void shutdown() override
@@ -60,29 +108,86 @@ public:
         quit();
     }
 
+    static int getOversamplingFactor (const String& commandLine)
+    {
+        const int factor = commandLine.fromFirstOccurrenceOf ("--oversample=", false, false).getIntValue();
+        return (factor == 2 || factor == 4 || factor == 8) ? factor : 1;
+    }
+
+    static File getSampleFolder()
+    {
+        // (this uses the parsed parameters, so that a quoted path can have spaces in it)
+        const StringArray params (getCommandLineParameterArray());
+
+        for (int i = 0; i < params.size(); ++i)
+            if (params[i].startsWith ("--samples="))
+                return File::getCurrentWorkingDirectory().getChildFile (params[i].fromFirstOccurrenceOf ("=", false, false).unquoted());
+
+        return File::nonexistent;
+    }
+
     //==============================================================================
     // This class is the desktop window for our app..
     class MainWindow    : public DocumentWindow
     {
     public:
-        MainWindow (String name)  : DocumentWindow (name,
-                                                    Colours::lightgrey,
-                                                    DocumentWindow::allButtons)
+        MainWindow (String name, bool useOpenGL, bool showFrameStats,
+                    int numVoiceRenderThreads, int oversamplingFactor, bool useMPE,
+                    const File& sampleFolder)
+            : DocumentWindow (name, Colours::lightgrey, DocumentWindow::allButtons),
+              frameStatsEnabled (showFrameStats)
         {
             setUsingNativeTitleBar (true);
-            Component* content = new ProjucerDemoClasses::MainComponent();
+            ProjucerDemoClasses::MainComponent* content = new ProjucerDemoClasses::MainComponent();
+            content->setNumVoiceRenderThreads (numVoiceRenderThreads);
+            content->setOversamplingFactor (oversamplingFactor);
+            content->setMPEEnabled (useMPE);
+
+            if (sampleFolder.isDirectory() && ! content->loadSamples (sampleFolder))
+                Logger::writeToLog ("No samples found in " + sampleFolder.getFullPathName());
 
             setContentOwned (content, true);
+
+            if (useOpenGL)
+                openGLContext.attachTo (*content);
+
+            if (frameStatsEnabled)
+            {
+                frameStatsOverlay.setAlwaysOnTop (true);
+                content->addAndMakeVisible (frameStatsOverlay);
+            }
+
             centreWithSize (getWidth(), getHeight());
             setVisible (true);
         }
 
+        ~MainWindow()
+        {
+            if (frameStatsEnabled)
+                Logger::writeToLog (ProjucerDemoClasses::FrameTimingMonitor::createJSONDump());
+
+            // the context must be detached before the content component gets deleted
+            openGLContext.detach();
+        }
+
+        void resized() override
+        {
+            DocumentWindow::resized();
+
+            if (Component* content = getContentComponent())
+                frameStatsOverlay.setBounds (content->getLocalBounds());
+        }
+
         void closeButtonPressed() override
         {
             JUCEApplication::getInstance()->systemRequestedQuit();
         }
 
     private:
+        OpenGLContext openGLContext;
+        ProjucerDemoClasses::FrameTimingOverlay frameStatsOverlay;
+        const bool frameStatsEnabled;
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
     };
 
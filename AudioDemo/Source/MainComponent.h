@@ -20,14 +20,25 @@
 //==============================================================================
 class MainComponent   : public Component,
                         public AudioIODeviceCallback,
-                        public MidiInputCallback
+                        public MidiInputCallback,
+                        private Slider::Listener
 {
 public:
     //==========================================================================
     MainComponent()
         : midiKeyboardState(),
-          midiKeyboardComponent (midiKeyboardState, MidiKeyboardComponent::Orientation::horizontalKeyboard)
+          midiKeyboardComponent (midiKeyboardState, MidiKeyboardComponent::Orientation::horizontalKeyboard),
+          masterGain (parameters.add ("masterGain", 0.0f, 2.0f, 1.0f))
     {
+        // the synth has to be complete before the audio and MIDI start
+        synth.addSineSound (new SineWaveSound());
+        for (int i = 0; i < maxNumVoices; ++i)
+            synth.addSineVoice();
+
+        // notes start on 32-sample boundaries (under a millisecond apart), so that
+        // dense MIDI can't break the voices' rendering up into tiny pieces
+        synth.setMidiQuantisation (32);
+
         audioDeviceManager.initialiseWithDefaultDevices (0, 2);
         audioDeviceManager.addMidiInputCallback (String::empty, this);
         audioDeviceManager.addAudioCallback (this);
@@ -37,14 +48,29 @@ public:
             audioDeviceManager.setMidiInputEnabled (devices[i], true);
         
         midiKeyboardState.addListener (&midiCollector);
-        
-        synth.addSound (new SineWaveSound());
-        for (int i = 0; i < maxNumVoices; ++i)
-            synth.addVoice (new SineWaveVoice());
+
+        // the gain goes straight into its parameter, and the release time gets
+        // pushed to the voices as part of a new Settings snapshot
+        gainSlider.setRange (masterGain.getMinimum(), masterGain.getMaximum());
+        gainSlider.setValue (masterGain.get(), dontSendNotification);
+        releaseSlider.setRange (0.005, 2.0);
+        releaseSlider.setSkewFactorFromMidPoint (0.25);
+        releaseSlider.setTextValueSuffix (" s");
+        releaseSlider.setValue (editedVoiceSettings.envelope.releaseSeconds, dontSendNotification);
+
+        for (auto* slider : { &gainSlider, &releaseSlider })
+        {
+            slider->addListener (this);
+            addAndMakeVisible (slider);
+        }
+
+        gainLabel.attachToComponent (&gainSlider, true);
+        releaseLabel.attachToComponent (&releaseSlider, true);
 
         addAndMakeVisible (oscilloscope);
+        addAndMakeVisible (spectrumAnalyser);
         addAndMakeVisible (midiKeyboardComponent);
-        setSize (500, 400);
+        setSize (500, 552);
     }
 
     //==========================================================================
@@ -54,11 +80,71 @@ public:
         audioDeviceManager.removeMidiInputCallback (String::empty, this);
     }
     
+    //==========================================================================
+    // Call these from the message thread: the changes get picked up at the start of
+    // the next audio block, without the two threads ever having to lock each other out.
+    void setVoiceSettings (const SineWaveVoice::Settings& newSettings)
+    {
+        voiceSettingsExchange.push (newSettings);
+    }
+
+    ParameterStore& getParameters() noexcept    { return parameters; }
+
+    /** Spreads the synth's voices across this many threads (counting the audio thread).
+        It takes effect straight away if the audio is running.
+    */
+    void setNumVoiceRenderThreads (int numThreads)
+    {
+        numVoiceRenderThreads = numThreads;
+
+        if (AudioIODevice* device = audioDeviceManager.getCurrentAudioDevice())
+            synth.setNumRenderThreads (numVoiceRenderThreads, device->getCurrentBufferSizeSamples());
+    }
+
+    /** Renders the synth's voices at 1, 2, 4 or 8 times the device's sample rate.
+        It takes effect straight away if the audio is running (stopping any notes).
+    */
+    void setOversamplingFactor (int factor)
+    {
+        oversamplingFactor = factor;
+
+        if (AudioIODevice* device = audioDeviceManager.getCurrentAudioDevice())
+            synth.setOversampling (oversamplingFactor, device->getCurrentBufferSizeSamples());
+    }
+
+    /** Treats the MIDI channels as an MPE zone (see DemoSynth::setMPEEnabled()). The
+        on-screen keyboard plays on the first member channel, as the master channel
+        doesn't play notes.
+    */
+    void setMPEEnabled (bool shouldBeEnabled)
+    {
+        synth.setMPEEnabled (shouldBeEnabled);
+        midiKeyboardComponent.setMidiChannel (shouldBeEnabled ? 2 : 1);
+    }
+
+    /** Plays the samples in a folder instead of the sine synth (see SamplerSynth::loadSamples()).
+        Only call this once. Returns false if there weren't any samples to load.
+    */
+    bool loadSamples (const File& folder)
+    {
+        if (sampler.loadSamples (folder) == 0)
+            return false;
+
+        usingSampler.store (true, std::memory_order_release);
+        return true;
+    }
+
     //==========================================================================
     void resized() override
     {
         Rectangle<int> r = getLocalBounds();
         midiKeyboardComponent.setBounds (r.removeFromBottom (80));
+
+        Rectangle<int> controls (r.removeFromBottom (32).reduced (4));
+        gainSlider.setBounds (controls.removeFromLeft (controls.getWidth() / 2).withTrimmedLeft (60));
+        releaseSlider.setBounds (controls.withTrimmedLeft (70));
+
+        spectrumAnalyser.setBounds (r.removeFromBottom (150));
         oscilloscope.setBounds (r);
     }
 
@@ -69,27 +155,76 @@ public:
                                 int           numOutputChannels,
                                 int           numSamples) override
     {
-        AudioBuffer<float> buffer (outputChannelData, numOutputChannels, numSamples);
-        buffer.clear();
-        
-        MidiBuffer incomingMidi;
-        midiCollector.removeNextBlockOfMessages (incomingMidi, numSamples);
-        synth.renderNextBlock (buffer, incomingMidi, 0, numSamples);
-        
-        oscilloscope.pushBuffer (outputChannelData[0], numSamples);
+        if (voiceSettingsExchange.pull (voiceSettings))
+            for (auto* voice : synth.getSineVoices())
+                voice->setSettings (voiceSettings);
+
+        midiCollector.removeNextBlockOfMessages (renderContext.incomingMidi, numSamples);
+
+        const bool playSamples = usingSampler.load (std::memory_order_acquire);
+
+        if (renderContext.incomingMidi.isEmpty()
+             && ! (playSamples ? sampler.isAnyVoicePlaying() : synth.isAnyVoicePlaying()))
+        {
+            // Nothing's playing and nothing's about to start, so the block is silent:
+            // there's nothing to render, and the visualisers just get told about it.
+            for (int i = 0; i < numOutputChannels; ++i)
+                if (outputChannelData[i] != nullptr)
+                    FloatVectorOperations::clear (outputChannelData[i], numSamples);
+
+            analysisBus.publishSilence (numSamples);
+            return;
+        }
+
+        // The synth renders straight into the first output channel (so there's no need
+        // to clear it first), and the other channels are copied from it with the gain
+        // applied on the way. The first channel is then what gets published for the
+        // visualisers, which pull it from the bus on the message thread.
+        AudioBuffer<float>& monoBuffer = renderContext.getMonoBuffer (outputChannelData, numOutputChannels, numSamples);
+
+        if (playSamples)
+        {
+            // (the sampler adds its voices to the buffer, rather than overwriting it)
+            monoBuffer.clear();
+            sampler.renderNextBlock (monoBuffer, renderContext.incomingMidi, 0, numSamples);
+        }
+        else
+        {
+            synth.renderNextBlockQuantised (monoBuffer, renderContext.incomingMidi, 0, numSamples);
+        }
+
+        float* const mono = monoBuffer.getWritePointer (0);
+        const float gain = masterGain.get();
+
+        for (int i = 1; i < numOutputChannels; ++i)
+            if (outputChannelData[i] != nullptr)
+                FloatVectorOperations::copyWithMultiply (outputChannelData[i], mono, gain, numSamples);
+
+        if (gain != 1.0f)
+            FloatVectorOperations::multiply (mono, gain, numSamples);
+
+        analysisBus.publish (&mono, 1, numSamples);
     }
 
     //==========================================================================
     void audioDeviceAboutToStart (AudioIODevice* device) override
     {
+        renderContext.prepare (device->getCurrentBufferSizeSamples());
+        synth.setNumRenderThreads (numVoiceRenderThreads, device->getCurrentBufferSizeSamples());
+        synth.setOversampling (oversamplingFactor, device->getCurrentBufferSizeSamples());
+
         const double sampleRate = device->getCurrentSampleRate();
         midiCollector.reset (sampleRate);
         synth.setCurrentPlaybackSampleRate (sampleRate);
+        sampler.setCurrentPlaybackSampleRate (sampleRate);
+        spectrumAnalyser.setSampleRate (sampleRate);
+        analysisBus.clear();
     }
 
     //==========================================================================
     virtual void audioDeviceStopped() override
     {
+        analysisBus.clear();
     }
     
     //==========================================================================
@@ -99,15 +234,75 @@ public:
         midiCollector.addMessageToQueue (message);
     }
 
+    //==========================================================================
+    void sliderValueChanged (Slider* slider) override
+    {
+        if (slider == &gainSlider)
+        {
+            masterGain.set ((float) gainSlider.getValue());
+        }
+        else if (slider == &releaseSlider)
+        {
+            editedVoiceSettings.envelope.releaseSeconds = (float) releaseSlider.getValue();
+            setVoiceSettings (editedVoiceSettings);
+        }
+    }
+
 private:
     //==========================================================================
+    /* The buffers that the audio callback uses. They're all allocated before the
+       audio starts, so the callback never has to allocate or build anything.
+    */
+    struct RenderContext
+    {
+        void prepare (int maximumBlockSize)
+        {
+            scratchBuffer.setSize (1, maximumBlockSize);
+            incomingMidi.ensureSize (2048);
+        }
+
+        /** Returns a one-channel buffer that refers to the device's first output
+            channel, or to the scratch buffer if there isn't one.
+        */
+        AudioBuffer<float>& getMonoBuffer (float** outputChannelData, int numOutputChannels, int numSamples)
+        {
+            float* channel = (numOutputChannels > 0 && outputChannelData[0] != nullptr)
+                                ? outputChannelData[0] : scratchBuffer.getWritePointer (0);
+
+            jassert (channel != scratchBuffer.getWritePointer (0) || numSamples <= scratchBuffer.getNumSamples());
+
+            monoBuffer.setDataToReferTo (&channel, 1, numSamples);
+            return monoBuffer;
+        }
+
+        AudioBuffer<float> monoBuffer, scratchBuffer;
+        MidiBuffer incomingMidi;
+    };
+
     AudioDeviceManager audioDeviceManager;
-    Oscilloscope oscilloscope;
-    Synthesiser synth;
+    AnalysisBus analysisBus { 1, 16384 };
+    Oscilloscope oscilloscope { analysisBus };
+    SpectrumAnalyser spectrumAnalyser { analysisBus };
+    DemoSynth synth;
+    RenderContext renderContext;
     MidiMessageCollector midiCollector;
     MidiKeyboardState midiKeyboardState;
     MidiKeyboardComponent midiKeyboardComponent;
     const int maxNumVoices = 16;
+    SamplerSynth sampler { maxNumVoices };
+    std::atomic<bool> usingSampler { false };
+    int numVoiceRenderThreads = 1;
+    int oversamplingFactor = 1;
+
+    ParameterStore parameters;
+    AtomicParameter& masterGain;
+    SnapshotExchange<SineWaveVoice::Settings> voiceSettingsExchange;
+    SineWaveVoice::Settings voiceSettings;         // the audio thread's copy
+    SineWaveVoice::Settings editedVoiceSettings;   // the message thread's copy
+
+    Slider gainSlider { Slider::LinearHorizontal, Slider::TextBoxRight },
+           releaseSlider { Slider::LinearHorizontal, Slider::TextBoxRight };
+    Label gainLabel { String(), "Gain" }, releaseLabel { String(), "Release" };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
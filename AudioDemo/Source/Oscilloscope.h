@@ -17,26 +17,26 @@
 #ifndef OSCILLOSCOPE_H_INCLUDED
 #define OSCILLOSCOPE_H_INCLUDED
 
-class Oscilloscope : public Component, private Timer
+/* Shows the latest audio published to an AnalysisBus. It grabs a snapshot of
+   the bus on each animation tick, so the audio thread doesn't do anything for it.
+*/
+class Oscilloscope : public Component, private AnimationScheduler::Client
 {
 public:
     //==========================================================================
-    Oscilloscope()
-        : writePos (0)
+    Oscilloscope (const AnalysisBus& source)
+        : AnimationScheduler::Client (*this, 40.0),
+          bus (source),
+          isShowingSilence (true)
     {
-        startTimer (40);
-    }
-    
-    //==========================================================================
-    void pushBuffer (const float* data, int numSamples)
-    {
-        for (int i = 0; i < numSamples; ++i)
-            buffer[++writePos % buffer.size()] = data[i];
+        buffer.fill (0.0f);
     }
     
     //==========================================================================
     void paint (Graphics& g) override
     {
+        const FrameTimingMonitor::ScopedPaint scopedPaint (frameTiming);
+
         g.fillAll (Colours::black);
         Rectangle<int> r = getLocalBounds();
         Path path;
@@ -68,17 +68,38 @@ public:
     
 private:
     //==========================================================================
-    void timerCallback() override
+    void animationTick() override
     {
+        frameTiming.timerTicked();
+
+        // Once everything in the buffer would be silence, the trace is just a flat
+        // line, so there's no need to grab it or repaint it again until it changes.
+        if (bus.getNumSilentSamples() >= (int) buffer.size())
+        {
+            if (isShowingSilence)
+                return;
+
+            buffer.fill (0.0f);
+            isShowingSilence = true;
+        }
+        else
+        {
+            bus.copyLatest (buffer.data(), (int) buffer.size());
+            isShowingSilence = false;
+        }
+
         repaint();
     }
     
     //==========================================================================
+    const AnalysisBus& bus;
     std::array<float, 1024> buffer;
-    std::size_t writePos;
+    bool isShowingSilence;
     
     const int bufferSize = 16384;
     const int paintSize = 256;
+
+    FrameTimingMonitor frameTiming { "Oscilloscope", 40.0 };
 };
 
 
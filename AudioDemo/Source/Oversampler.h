@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef OVERSAMPLER_H_INCLUDED
+#define OVERSAMPLER_H_INCLUDED
+
+/* Brings audio that was rendered at 2, 4 or 8 times the playback sample rate
+   back down to it, filtering out everything above the new Nyquist limit first
+   so that it doesn't alias.
+
+   Each halving of the rate is done by a half-band FIR filter. Every other
+   coefficient of a half-band filter is zero, so it splits neatly into two
+   polyphase branches: one half of the input samples only goes through the
+   centre tap, and the other half goes through all the rest - which are
+   symmetrical, so each pair of them only needs one multiply. The filters are
+   applied one tap at a time across the whole block with FloatVectorOperations,
+   so the work gets vectorised.
+
+   Only the last stage (the one down to the playback rate) needs a sharp cut-off,
+   to keep everything up to 20kHz at 44.1kHz. The earlier ones only have to stop
+   whatever would fold down into that 0-20kHz band, which leaves them a much
+   wider transition band, so they can be much shorter. They still need the same
+   rejection, though: e.g. going from 4x to 2x, everything from 68.2kHz to 88.2kHz
+   lands straight in the last stage's passband, so it has to be ~80dB down too.
+*/
+class Oversampler
+{
+public:
+    enum { maxFactor = 8 };
+
+    /** The factor must be 2, 4 or 8, and the maximum block size is the largest
+        number of samples (at the playback rate) that process() will be asked for.
+    */
+    Oversampler (int factor, int maximumBlockSize)
+        : maxBlockSize (maximumBlockSize)
+    {
+        jassert (factor == 2 || factor == 4 || factor == 8);
+
+        for (int stageFactor = factor; stageFactor > 1; stageFactor /= 2)
+            stages.add (stageFactor == 2 ? new HalfBandDecimator (28, 8.0, maximumBlockSize)
+                                         : new HalfBandDecimator (6, 8.5, maximumBlockSize * stageFactor / 2));
+
+        inputBuffer.allocate ((size_t) (maximumBlockSize * factor), true);
+    }
+
+    int getFactor() const noexcept              { return 1 << stages.size(); }
+    int getMaximumBlockSize() const noexcept    { return maxBlockSize; }
+
+    /** This is where the audio to be decimated goes: the first numSamples * getFactor()
+        samples are what the next call to process() will use.
+    */
+    float* getInputBuffer() noexcept            { return inputBuffer; }
+
+    /** Filters and decimates numSamples * getFactor() samples from the input buffer,
+        and writes the resulting numSamples into dest. The input buffer gets overwritten.
+    */
+    void process (float* dest, int numSamples) noexcept
+    {
+        jassert (numSamples <= maxBlockSize);
+
+        // each stage halves the rate, working in place until the last one
+        for (int i = 0; i < stages.size(); ++i)
+        {
+            const int numOut = numSamples << (stages.size() - 1 - i);
+            stages.getUnchecked (i)->process (inputBuffer, i == stages.size() - 1 ? dest : inputBuffer.getData(), numOut);
+        }
+    }
+
+    /** Clears the filters' history. */
+    void reset() noexcept
+    {
+        for (auto* stage : stages)
+            stage->reset();
+    }
+
+private:
+    //==========================================================================
+    struct HalfBandDecimator
+    {
+        // The filter has 4 * numCoefficientPairs - 1 taps, windowed with a Kaiser
+        // window - a larger beta gives more stopband rejection but a wider transition.
+        HalfBandDecimator (int numCoefficientPairs, double kaiserBeta, int maximumOutputBlockSize)
+            : numPairs (numCoefficientPairs),
+              centreHistory (numCoefficientPairs - 1),
+              pairsHistory (2 * numCoefficientPairs - 1)
+        {
+            coefficients.allocate ((size_t) numPairs, true);
+            centrePhase.allocate ((size_t) (centreHistory + maximumOutputBlockSize), true);
+            pairsPhase.allocate ((size_t) (pairsHistory + maximumOutputBlockSize), true);
+            pairSums.allocate ((size_t) maximumOutputBlockSize, true);
+
+            // The ideal half-band filter's coefficients, 1, 3, 5.. taps either side of the
+            // centre, are +-1 / (pi * distance). They're scaled so that the DC gain is 1.
+            const double halfLength = 2.0 * numPairs;
+            double sum = 0;
+
+            for (int j = 0; j < numPairs; ++j)
+            {
+                const int distance = 2 * j + 1;
+                const double ratio = distance / halfLength;
+                const double window = besselI0 (kaiserBeta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (kaiserBeta);
+                const double ideal = ((j & 1) != 0 ? -1.0 : 1.0) / (double_Pi * distance);
+
+                coefficients[j] = (float) (ideal * window);
+                sum += ideal * window;
+            }
+
+            // the centre tap is 0.5, so each side's taps must add up to 0.25
+            FloatVectorOperations::multiply (coefficients, (float) (0.25 / sum), numPairs);
+        }
+
+        void reset() noexcept
+        {
+            FloatVectorOperations::clear (centrePhase, centreHistory);
+            FloatVectorOperations::clear (pairsPhase, pairsHistory);
+        }
+
+        // Reads 2 * numOut samples from input, and writes numOut samples to output
+        // (which can be the same buffer).
+        void process (const float* input, float* output, int numOut) noexcept
+        {
+            // split the input into its two phases, each after the history it needs
+            float* const centre = centrePhase + centreHistory;
+            float* const pairs = pairsPhase + pairsHistory;
+
+            for (int i = 0; i < numOut; ++i)
+            {
+                centre[i] = input[2 * i];
+                pairs[i]  = input[2 * i + 1];
+            }
+
+            // the centre tap is a plain delay..
+            FloatVectorOperations::copyWithMultiply (output, centrePhase, 0.5f, numOut);
+
+            // ..and each pair of taps adds the two samples that it straddles, then scales them
+            for (int j = 0; j < numPairs; ++j)
+            {
+                FloatVectorOperations::add (pairSums, pairsPhase + numPairs + j, pairsPhase + numPairs - 1 - j, numOut);
+                FloatVectorOperations::addWithMultiply (output, pairSums, coefficients[j], numOut);
+            }
+
+            // keep the end of each phase for the next block
+            memmove (centrePhase, centrePhase + numOut, (size_t) centreHistory * sizeof (float));
+            memmove (pairsPhase, pairsPhase + numOut, (size_t) pairsHistory * sizeof (float));
+        }
+
+        static double besselI0 (double x) noexcept
+        {
+            double sum = 1.0, term = 1.0;
+
+            for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+            {
+                const double t = x / (2.0 * k);
+                term *= t * t;
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        const int numPairs, centreHistory, pairsHistory;
+        HeapBlock<float> coefficients, centrePhase, pairsPhase, pairSums;
+
+        JUCE_DECLARE_NON_COPYABLE (HalfBandDecimator)
+    };
+
+    //==========================================================================
+    OwnedArray<HalfBandDecimator> stages;
+    HeapBlock<float> inputBuffer;
+    const int maxBlockSize;
+
+    JUCE_DECLARE_NON_COPYABLE (Oversampler)
+};
+
+
+#endif  // OVERSAMPLER_H_INCLUDED
@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SAMPLER_H_INCLUDED
+#define SAMPLER_H_INCLUDED
+
+//==============================================================================
+/* One sample, which is played from its file rather than being loaded into memory.
+
+   The file is memory-mapped, so only the parts that get played are ever read in
+   (and the OS can drop them again when it likes). The first second or so is
+   copied into memory when it's loaded, so that a note can start straight away -
+   the voices stream the rest on a background thread.
+
+   Everything is mixed down to mono, to match the rest of the synth.
+*/
+class StreamedSamplerSound  : public SynthesiserSound
+{
+public:
+    StreamedSamplerSound (MemoryMappedAudioFormatReader* sourceReader, int rootMidiNote,
+                          const BigInteger& notesToPlayOn, int maxPreloadFrames)
+        : reader (sourceReader),
+          midiNotes (notesToPlayOn),
+          rootNote (rootMidiNote),
+          preloadLength ((int) jmin ((int64) maxPreloadFrames, sourceReader->lengthInSamples))
+    {
+        preload.setSize (1, preloadLength);
+
+        AudioBuffer<float> scratch;
+        readMono (preload.getWritePointer (0), 0, preloadLength, scratch);
+    }
+
+    bool appliesToNote (int midiNoteNumber) override        { return midiNotes[midiNoteNumber]; }
+    bool appliesToChannel (int /*midiChannel*/) override    { return true; }
+
+    int getRootNote() const noexcept                { return rootNote; }
+    double getSampleRate() const noexcept           { return reader->sampleRate; }
+    int64 getLength() const noexcept                { return reader->lengthInSamples; }
+    int getPreloadLength() const noexcept           { return preloadLength; }
+    const float* getPreloadedFrames() const noexcept    { return preload.getReadPointer (0); }
+
+    /** Reads some frames from the file and mixes them down into dest. This touches the
+        disk, so it must never be called on the audio thread - only the streaming
+        thread uses it once the sound has been created.
+    */
+    void readMono (float* dest, int64 startFrame, int numFrames, AudioBuffer<float>& scratch)
+    {
+        // (a mono file gets read into both channels)
+        scratch.setSize (2, numFrames, false, false, true);
+        reader->read (&scratch, 0, numFrames, startFrame, true, true);
+
+        FloatVectorOperations::copyWithMultiply (dest, scratch.getReadPointer (0), 0.5f, numFrames);
+        FloatVectorOperations::addWithMultiply (dest, scratch.getReadPointer (1), 0.5f, numFrames);
+    }
+
+private:
+    ScopedPointer<MemoryMappedAudioFormatReader> reader;
+    BigInteger midiNotes;
+    const int rootNote, preloadLength;
+    AudioBuffer<float> preload;
+
+    JUCE_LEAK_DETECTOR (StreamedSamplerSound)
+};
+
+//==============================================================================
+/* A voice that plays a StreamedSamplerSound.
+
+   The start of the note comes from the sound's preloaded frames. Meanwhile, a
+   background thread reads the frames after that into a ring buffer that belongs
+   to the voice, staying as far ahead of the playback position as the ring allows.
+   The audio thread never touches the file itself.
+
+   The two threads only share a few atomics. Each note gets a new number, and the
+   streaming thread tags what it's buffered with the number of the note it was
+   buffering for, so that if a voice gets restarted while the thread is busy, the
+   frames meant for the old note are just ignored. If the thread ever falls
+   behind, the missing frames are played as silence rather than waited for.
+*/
+class StreamedSamplerVoice  : public SynthesiserVoice,
+                              public TimeSliceClient
+{
+public:
+    StreamedSamplerVoice()
+        : ring (1, ringSize),
+          sound (nullptr), playPosition (0), pitchRatio (1.0), level (0), noteId (0),
+          requestedNote (0), streamingSound (nullptr), framesConsumed (0), bufferedState (0),
+          streamedNote (0), streamPosition (0)
+    {
+        ADSREnvelope::Parameters parameters;
+        parameters.attackSeconds = 0.001f;
+        parameters.releaseSeconds = 0.15f;
+        envelope.setParameters (parameters);
+    }
+
+    void setCurrentPlaybackSampleRate (double newRate) override
+    {
+        SynthesiserVoice::setCurrentPlaybackSampleRate (newRate);
+        envelope.setSampleRate (newRate);
+    }
+
+    bool canPlaySound (SynthesiserSound* s) override
+    {
+        return dynamic_cast<StreamedSamplerSound*> (s) != nullptr;
+    }
+
+    void startNote (int midiNoteNumber, float velocity, SynthesiserSound* s, int /*currentPitchWheelPosition*/) override
+    {
+        sound = dynamic_cast<StreamedSamplerSound*> (s);
+        jassert (sound != nullptr);
+
+        playPosition = 0;
+        pitchRatio = std::pow (2.0, (midiNoteNumber - sound->getRootNote()) / 12.0)
+                        * sound->getSampleRate() / getSampleRate();
+        level = velocity;
+        envelope.noteOn();
+
+        // tell the streaming thread about the new note
+        framesConsumed.store (0, std::memory_order_relaxed);
+        streamingSound.store (sound, std::memory_order_relaxed);
+        requestedNote.store (++noteId, std::memory_order_release);
+    }
+
+    void stopNote (float /*velocity*/, bool allowTailOff) override
+    {
+        if (allowTailOff)
+        {
+            envelope.noteOff();
+        }
+        else
+        {
+            clearCurrentNote();
+            envelope.reset();
+        }
+    }
+
+    void pitchWheelMoved (int /*newValue*/) override                            {}
+    void controllerMoved (int /*controllerNumber*/, int /*newValue*/) override  {}
+
+    void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
+    {
+        float temp[chunkSize];
+
+        while (numSamples > 0 && isVoiceActive())
+        {
+            const int num = jmin (numSamples, (int) chunkSize);
+            renderMono (temp, num, true);
+
+            for (int i = outputBuffer.getNumChannels(); --i >= 0;)
+                outputBuffer.addFrom (i, startSample, temp, num);
+
+            startSample += num;
+            numSamples -= num;
+        }
+    }
+
+    /** Renders the next numSamples of this voice into a single channel, in the same
+        way as SineWaveVoice::renderMono().
+    */
+    void renderMono (float* dest, int numSamples, bool overwrite) noexcept
+    {
+        int i = 0;
+
+        if (sound != nullptr && envelope.isActive())
+        {
+            const int64 streamedEnd = getStreamedEnd();
+            float samples[chunkSize], gains[chunkSize];
+
+            while (i < numSamples)
+            {
+                const int num = jmin (numSamples - i, (int) chunkSize);
+                const int numSounding = envelope.getNextBlock (gains, num);
+                const int numRead = readFrames (samples, numSounding, streamedEnd);
+
+                FloatVectorOperations::multiply (samples, gains, numRead);
+
+                if (overwrite)  FloatVectorOperations::copyWithMultiply (dest + i, samples, level, numRead);
+                else            FloatVectorOperations::addWithMultiply (dest + i, samples, level, numRead);
+
+                i += numRead;
+
+                if (numRead < num)
+                {
+                    // the release has finished, or we've got to the end of the sample
+                    clearCurrentNote();
+                    envelope.reset();
+                    break;
+                }
+            }
+
+            // the streaming thread can now reuse the part of the ring before this point
+            framesConsumed.store ((int64) playPosition, std::memory_order_release);
+        }
+
+        if (overwrite && i < numSamples)
+            FloatVectorOperations::clear (dest + i, numSamples - i);
+    }
+
+    //==========================================================================
+    /** Called on the streaming thread: tops up the ring buffer for the current note. */
+    int useTimeSlice() override
+    {
+        const uint32 note = requestedNote.load (std::memory_order_acquire);
+        StreamedSamplerSound* const s = streamingSound.load (std::memory_order_relaxed);
+
+        if (s == nullptr)
+            return idleWaitMs;
+
+        if (note != streamedNote)
+        {
+            streamedNote = note;
+            streamPosition = s->getPreloadLength();
+        }
+
+        // (if the voice has moved on to another note since we read its number,
+        // whatever gets written here will be ignored)
+        const int64 consumed = framesConsumed.load (std::memory_order_acquire);
+        const int64 end = jmin (s->getLength(), consumed + ringSize);
+        const int numToRead = (int) jmin ((int64) maxFramesPerSlice, end - streamPosition);
+
+        if (numToRead <= 0)
+            return idleWaitMs;
+
+        // the read may have to wrap round the end of the ring
+        const int startIndex = (int) (streamPosition & ringMask);
+        const int numBeforeWrap = jmin (numToRead, ringSize - startIndex);
+
+        s->readMono (ring.getWritePointer (0, startIndex), streamPosition, numBeforeWrap, scratchBuffer);
+
+        if (numToRead > numBeforeWrap)
+            s->readMono (ring.getWritePointer (0), streamPosition + numBeforeWrap, numToRead - numBeforeWrap, scratchBuffer);
+
+        streamPosition += numToRead;
+        bufferedState.store (packState (note, streamPosition), std::memory_order_release);
+
+        return 0;   // (there may well be more to do straight away)
+    }
+
+private:
+    //==========================================================================
+    enum
+    {
+        chunkSize = 64,
+        ringSize = 32768,
+        ringMask = ringSize - 1,
+        maxFramesPerSlice = 4096,
+        idleWaitMs = 5
+    };
+
+    AudioBuffer<float> ring;
+    ADSREnvelope envelope;
+
+    // the audio thread's state
+    StreamedSamplerSound* sound;
+    double playPosition, pitchRatio;
+    float level;
+    uint32 noteId;
+
+    // shared between the two threads
+    std::atomic<uint32> requestedNote;
+    std::atomic<StreamedSamplerSound*> streamingSound;
+    std::atomic<int64> framesConsumed;
+    std::atomic<uint64> bufferedState;   // the note number, and how far it's buffered
+
+    // the streaming thread's state
+    uint32 streamedNote;
+    int64 streamPosition;
+    AudioBuffer<float> scratchBuffer;
+
+    // the bottom 40 bits are the frame position, and the rest are the note number
+    static uint64 packState (uint32 note, int64 position) noexcept
+    {
+        return ((uint64) note << 40) | (uint64) position;
+    }
+
+    // Returns how far the ring has been filled for the current note - or just the
+    // end of the preload, if the streaming thread hasn't got to this note yet.
+    int64 getStreamedEnd() const noexcept
+    {
+        const uint64 state = bufferedState.load (std::memory_order_acquire);
+
+        if ((uint32) (state >> 40) == (noteId & 0xffffff))
+            return (int64) (state & ((((uint64) 1) << 40) - 1));
+
+        return sound->getPreloadLength();
+    }
+
+    float getFrame (int64 frame, int64 streamedEnd) const noexcept
+    {
+        if (frame < sound->getPreloadLength())
+            return sound->getPreloadedFrames()[frame];
+
+        if (frame < streamedEnd)
+            return ring.getReadPointer (0)[frame & ringMask];
+
+        return 0.0f;   // the streaming thread hasn't got this far yet
+    }
+
+    // Reads up to numFrames with linear interpolation, and returns how many there
+    // were before the end of the sample.
+    int readFrames (float* dest, int numFrames, int64 streamedEnd) noexcept
+    {
+        const int64 length = sound->getLength();
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const int64 frame = (int64) playPosition;
+
+            if (frame + 1 >= length)
+                return i;
+
+            const float alpha = (float) (playPosition - (double) frame);
+            const float f0 = getFrame (frame, streamedEnd);
+            const float f1 = getFrame (frame + 1, streamedEnd);
+
+            dest[i] = f0 + alpha * (f1 - f0);
+            playPosition += pitchRatio;
+        }
+
+        return numFrames;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (StreamedSamplerVoice)
+};
+
+//==============================================================================
+/* A Synthesiser that plays a folder of samples with StreamedSamplerVoices, and
+   owns the thread that streams them.
+*/
+struct SamplerSynth  : public Synthesiser
+{
+    SamplerSynth (int numVoices)
+        : streamingThread ("Sample Streaming")
+    {
+        for (int i = 0; i < numVoices; ++i)
+        {
+            StreamedSamplerVoice* voice = new StreamedSamplerVoice();
+            addVoice (voice);
+            samplerVoices.add (voice);
+            streamingThread.addTimeSliceClient (voice);
+        }
+
+        streamingThread.startThread (6);
+    }
+
+    ~SamplerSynth()
+    {
+        // (this has to happen before the Synthesiser deletes the voices)
+        streamingThread.stopThread (1000);
+    }
+
+    /** Loads every WAV or AIFF file in a folder, and returns how many it found. Each
+        file's root note is the number at the end of its name (e.g. "Piano 60.wav"),
+        and the notes in between the root notes get shared out to the nearest sample.
+        Only call this once, before any notes are played.
+    */
+    int loadSamples (const File& folder)
+    {
+        jassert (getNumSounds() == 0);
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        Array<File> filesByRootNote;
+        filesByRootNote.insertMultiple (0, File::nonexistent, 128);
+
+        DirectoryIterator iter (folder, false, "*.wav;*.aif;*.aiff");
+
+        while (iter.next())
+        {
+            const File file (iter.getFile());
+            const int rootNote = file.getFileNameWithoutExtension().getTrailingIntValue();
+
+            if (isPositiveAndBelow (rootNote, 128))
+                filesByRootNote.set (rootNote, file);
+        }
+
+        Array<int> rootNotes;
+
+        for (int note = 0; note < 128; ++note)
+            if (filesByRootNote.getReference (note) != File::nonexistent)
+                rootNotes.add (note);
+
+        int numLoaded = 0;
+
+        for (int i = 0; i < rootNotes.size(); ++i)
+        {
+            const int root = rootNotes.getUnchecked (i);
+            const int lowestNote  = i > 0 ? (rootNotes.getUnchecked (i - 1) + root) / 2 + 1 : 0;
+            const int highestNote = i < rootNotes.size() - 1 ? (root + rootNotes.getUnchecked (i + 1)) / 2 : 127;
+
+            const File& file = filesByRootNote.getReference (root);
+
+            if (AudioFormat* format = formatManager.findFormatForFileExtension (file.getFileExtension()))
+            {
+                ScopedPointer<MemoryMappedAudioFormatReader> reader (format->createMemoryMappedReader (file));
+
+                if (reader != nullptr && reader->mapEntireFile() && reader->lengthInSamples > 1)
+                {
+                    BigInteger notes;
+                    notes.setRange (lowestNote, highestNote + 1 - lowestNote, true);
+
+                    const int numPreloadSamples = roundToInt (preloadSeconds * reader->sampleRate);
+                    addSound (new StreamedSamplerSound (reader.release(), root, notes, numPreloadSamples));
+                    ++numLoaded;
+                }
+            }
+        }
+
+        return numLoaded;
+    }
+
+    /** Returns true if any voices are still sounding. Only call this from the audio thread. */
+    bool isAnyVoicePlaying() const noexcept
+    {
+        for (auto* voice : samplerVoices)
+            if (voice->isVoiceActive())
+                return true;
+
+        return false;
+    }
+
+private:
+    TimeSliceThread streamingThread;
+    Array<StreamedSamplerVoice*> samplerVoices;
+
+    // how much of the start of each sample is kept in memory
+    enum { preloadSeconds = 1 };
+
+    JUCE_DECLARE_NON_COPYABLE (SamplerSynth)
+};
+
+
+#endif  // SAMPLER_H_INCLUDED
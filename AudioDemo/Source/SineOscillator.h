@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SINEOSCILLATOR_H_INCLUDED
+#define SINEOSCILLATOR_H_INCLUDED
+
+/* One cycle of a sine wave, looked up with a 32-bit fixed-point phase.
+
+   The top bits of the phase pick the table entry, and the rest are used to
+   interpolate between it and the next one. There's an extra entry at the end
+   (a copy of the first), so the interpolation never has to wrap round.
+
+   There's only ever one of these - the oscillators all share it through a
+   SharedResourcePointer.
+*/
+class SineTable
+{
+public:
+    enum
+    {
+        indexBits = 11,
+        tableSize = 1 << indexBits,
+        fractionBits = 32 - indexBits
+    };
+
+    SineTable()
+    {
+        for (int i = 0; i < tableSize; ++i)
+            values[i] = (float) std::sin (2.0 * double_Pi * i / tableSize);
+
+        values[tableSize] = values[0];
+    }
+
+    float lookup (uint32 phase) const noexcept
+    {
+        const uint32 index = phase >> fractionBits;
+        const float fraction = (float) (phase & fractionMask) * (1.0f / (float) (1 << fractionBits));
+        const float v0 = values[index];
+
+        return v0 + fraction * (values[index + 1] - v0);
+    }
+
+private:
+    const uint32 fractionMask = (1u << fractionBits) - 1;
+    float values[tableSize + 1];
+
+    JUCE_DECLARE_NON_COPYABLE (SineTable)
+};
+
+//==============================================================================
+/* A sine wave oscillator with an integer phase accumulator.
+
+   A whole cycle is 2^32, so the phase wraps round by itself whenever it
+   overflows. Unlike an angle in radians that keeps on growing, it never
+   loses any precision, however long the note goes on for - and the same
+   frequency always produces exactly the same samples.
+*/
+class SineOscillator
+{
+public:
+    SineOscillator() noexcept
+        : phase (0), increment (0), targetIncrement (0), incrementStep (0), samplesToTarget (0)
+    {
+    }
+
+    /** Frequencies above the Nyquist limit are clipped to it. */
+    void setFrequency (double cyclesPerSecond, double sampleRate) noexcept
+    {
+        increment = targetIncrement = getIncrement (cyclesPerSecond, sampleRate);
+        samplesToTarget = 0;
+    }
+
+    /** Glides linearly from the current frequency to a new one over the next numSamples. */
+    void rampToFrequency (double cyclesPerSecond, double sampleRate, int numSamples) noexcept
+    {
+        targetIncrement = getIncrement (cyclesPerSecond, sampleRate);
+        samplesToTarget = jmax (1, numSamples);
+        incrementStep = (int32) (((int64) targetIncrement - (int64) increment) / samplesToTarget);
+    }
+
+    void resetPhase() noexcept      { phase = 0; }
+
+    /** Writes the next numSamples of the sine wave into dest. */
+    void fill (float* dest, int numSamples) noexcept
+    {
+        const SineTable& sineTable = *table;
+        int i = 0;
+
+        if (samplesToTarget > 0)
+        {
+            const int numRamping = jmin (numSamples, samplesToTarget);
+
+            for (; i < numRamping; ++i)
+            {
+                dest[i] = sineTable.lookup (phase);
+                phase += increment;
+                increment += (uint32) incrementStep;
+            }
+
+            // (the step gets rounded, so this makes sure the ramp ends up exactly on target)
+            if ((samplesToTarget -= numRamping) == 0)
+                increment = targetIncrement;
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            dest[i] = sineTable.lookup (phase);
+            phase += increment;
+        }
+    }
+
+private:
+    SharedResourcePointer<SineTable> table;
+    uint32 phase, increment, targetIncrement;
+    int32 incrementStep;
+    int samplesToTarget;
+
+    static uint32 getIncrement (double cyclesPerSecond, double sampleRate) noexcept
+    {
+        const double cyclesPerSample = jlimit (0.0, 0.5, cyclesPerSecond / sampleRate);
+        return (uint32) (cyclesPerSample * 4294967296.0 + 0.5);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SineOscillator)
+};
+
+
+#endif  // SINEOSCILLATOR_H_INCLUDED
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SMOOTHEDVALUE_H_INCLUDED
+#define SMOOTHEDVALUE_H_INCLUDED
+
+/* A value that glides to each new target with a linear ramp, a block at a time.
+
+   It's meant for things like MIDI controllers, which only change the target
+   now and then: the audio thread asks for the value at the end of each block
+   with getNextValue(), having used getCurrentValue() to get the value at the
+   start of it, and interpolates between the two. Between ramps, isSmoothing()
+   returns false and the caller doesn't need to do anything at all.
+*/
+class SmoothedValue
+{
+public:
+    SmoothedValue (double initialValue = 0.0) noexcept
+        : currentValue (initialValue), target (initialValue), step (0),
+          rampLengthSamples (1), samplesLeft (0)
+    {
+    }
+
+    /** Only affects ramps that start after this is called. */
+    void setRampLength (double seconds, double sampleRate) noexcept
+    {
+        rampLengthSamples = jmax (1, roundToInt (seconds * sampleRate));
+    }
+
+    /** Jumps straight to a new value, stopping any ramp. */
+    void setValue (double newValue) noexcept
+    {
+        currentValue = target = newValue;
+        samplesLeft = 0;
+    }
+
+    /** Starts a ramp from wherever the value is now to the new target. */
+    void setTarget (double newTarget) noexcept
+    {
+        if (newTarget == target)
+            return;
+
+        target = newTarget;
+        samplesLeft = rampLengthSamples;
+        step = (target - currentValue) / rampLengthSamples;
+    }
+
+    bool isSmoothing() const noexcept           { return samplesLeft > 0; }
+    double getTargetValue() const noexcept      { return target; }
+
+    /** Returns the value at the start of the next block. */
+    double getCurrentValue() const noexcept     { return currentValue; }
+
+    /** Moves the ramp on by a block of numSamples, and returns the value at the end of it. */
+    double getNextValue (int numSamples) noexcept
+    {
+        if (samplesLeft > 0)
+        {
+            const int numToRamp = jmin (numSamples, samplesLeft);
+            samplesLeft -= numToRamp;
+            currentValue = (samplesLeft == 0) ? target : currentValue + step * numToRamp;
+        }
+
+        return currentValue;
+    }
+
+private:
+    double currentValue, target, step;
+    int rampLengthSamples, samplesLeft;
+};
+
+
+#endif  // SMOOTHEDVALUE_H_INCLUDED
@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SPECTRUMANALYSER_H_INCLUDED
+#define SPECTRUMANALYSER_H_INCLUDED
+
+/* Shows the spectrum of the audio published to an AnalysisBus.
+
+   All the analysis happens on a background thread, which reads the bus,
+   runs Hann-windowed FFTs that overlap by three quarters, and smooths the
+   magnitudes over time. The finished spectra are handed over to the message
+   thread through a SnapshotExchange, and paint() only has to reduce them to
+   one point per couple of pixels on a log-frequency scale.
+
+   While the bus is silent, the thread skips over the audio without doing any
+   FFTs at all, and the display is left empty.
+*/
+class SpectrumAnalyser  : public Component,
+                          private AnimationScheduler::Client,
+                          private Thread
+{
+public:
+    //==========================================================================
+    SpectrumAnalyser (const AnalysisBus& source)
+        : AnimationScheduler::Client (*this, 1000.0 / 30.0),
+          Thread ("Spectrum Analyser"),
+          reader (source),
+          fft (fftOrder, false),
+          fifoFill (0),
+          isShowingSilence (false),
+          sampleRate (44100.0)
+    {
+        setOpaque (true);
+
+        window.allocate (fftSize, true);
+        fifo.allocate (fftSize, true);
+        fftData.allocate (2 * fftSize, true);
+        FloatVectorOperations::clear (averagedMagnitudes, numBins);
+        FloatVectorOperations::clear (spectrumToPaint.magnitudes, numBins);
+        spectrumToPaint.sampleRate = sampleRate;
+
+        // a Hann window, scaled so that a full-scale sine comes out at 0 dB
+        for (int i = 0; i < fftSize; ++i)
+            window[i] = (float) (0.5 - 0.5 * std::cos (2.0 * double_Pi * i / (fftSize - 1)));
+
+        FloatVectorOperations::multiply (window, 4.0f / fftSize, fftSize);
+
+        startThread (3);
+    }
+
+    ~SpectrumAnalyser()
+    {
+        stopThread (1000);
+    }
+
+    /** Can be called from any thread. */
+    void setSampleRate (double newSampleRate) noexcept
+    {
+        sampleRate.store (newSampleRate, std::memory_order_relaxed);
+    }
+
+    //==========================================================================
+    void paint (Graphics& g) override
+    {
+        const FrameTimingMonitor::ScopedPaint scopedPaint (frameTiming);
+
+        g.fillAll (Colours::black);
+
+        const float width = (float) getWidth();
+        const float height = (float) getHeight();
+        const double nyquist = spectrumToPaint.sampleRate * 0.5;
+
+        if (width <= 0 || nyquist <= minFrequency)
+            return;
+
+        // the decade lines
+        g.setColour (Colours::darkgrey);
+
+        for (double f = 100.0; f < nyquist; f *= 10.0)
+            g.drawVerticalLine (roundToInt (getXForFrequency (f, nyquist)), 0.0f, height);
+
+        // one point every couple of pixels, each taking the loudest bin underneath it
+        Path path;
+        const float binsPerHz = (float) (numBins / nyquist);
+
+        for (float x = 0; x < width; x += pixelsPerPoint)
+        {
+            const int firstBin = jlimit (0, numBins - 1, (int) (getFrequencyForX (x, nyquist) * binsPerHz));
+            const int lastBin  = jlimit (firstBin + 1, (int) numBins, (int) (getFrequencyForX (x + pixelsPerPoint, nyquist) * binsPerHz));
+
+            const float magnitude = FloatVectorOperations::findMaximum (spectrumToPaint.magnitudes + firstBin, lastBin - firstBin);
+            const float y = jmap (jlimit (minDecibels, 0.0f, Decibels::gainToDecibels (magnitude, minDecibels)),
+                                  minDecibels, 0.0f, height, 0.0f);
+
+            if (path.isEmpty())
+                path.startNewSubPath (x, y);
+            else
+                path.lineTo (x, y);
+        }
+
+        g.setColour (Colours::orange);
+        g.strokePath (path, PathStrokeType (1.5f));
+    }
+
+private:
+    //==========================================================================
+    enum
+    {
+        fftOrder = 11,
+        fftSize = 1 << fftOrder,
+        numBins = fftSize / 2,
+        hopSize = fftSize / 4
+    };
+
+    struct Spectrum
+    {
+        float magnitudes[numBins];
+        double sampleRate;
+    };
+
+    AnalysisBus::Reader reader;
+    FFT fft;
+    HeapBlock<float> window, fifo, fftData;
+    int fifoFill;
+    float averagedMagnitudes[numBins];
+    bool isShowingSilence;
+
+    std::atomic<double> sampleRate;
+    SnapshotExchange<Spectrum> spectrumExchange;
+    Spectrum spectrumToPaint;
+
+    const float minDecibels = -100.0f;
+    const double minFrequency = 20.0;
+    const float pixelsPerPoint = 2.0f;
+    const float averagingAmount = 0.3f;   // how much of each new frame goes into the average
+
+    FrameTimingMonitor frameTiming { "SpectrumAnalyser", 1000.0 / 30.0 };
+
+    //==========================================================================
+    float getXForFrequency (double frequency, double nyquist) const
+    {
+        return (float) (getWidth() * std::log (frequency / minFrequency) / std::log (nyquist / minFrequency));
+    }
+
+    double getFrequencyForX (float x, double nyquist) const
+    {
+        return minFrequency * std::pow (nyquist / minFrequency, x / getWidth());
+    }
+
+    void animationTick() override
+    {
+        frameTiming.timerTicked();
+
+        if (spectrumExchange.pull (spectrumToPaint))
+            repaint();
+    }
+
+    //==========================================================================
+    // The background thread: every time another hop's worth of audio has come
+    // in, the last fftSize samples get analysed.
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (reader.checkAndResetCleared())
+            {
+                fifoFill = 0;
+                FloatVectorOperations::clear (averagedMagnitudes, numBins);
+                publishSpectrum();
+            }
+
+            if (reader.getNumSilentSamples() >= fftSize)
+            {
+                // any frames from here on would be all zeros
+                reader.skipToEnd();
+
+                if (! isShowingSilence)
+                {
+                    fifoFill = 0;
+                    FloatVectorOperations::clear (averagedMagnitudes, numBins);
+                    publishSpectrum();
+                    isShowingSilence = true;
+                }
+
+                wait (10);
+                continue;
+            }
+
+            isShowingSilence = false;
+            bool anyNewFrames = false;
+
+            for (;;)
+            {
+                float* const dest = fifo + fifoFill;
+                const int num = reader.read (&dest, 1, fftSize - fifoFill);
+
+                if (num == 0)
+                    break;
+
+                fifoFill += num;
+
+                if (fifoFill == fftSize)
+                {
+                    analyseFrame();
+                    anyNewFrames = true;
+
+                    // keep the overlapping part for the next frame
+                    memmove (fifo, fifo + hopSize, (fftSize - hopSize) * sizeof (float));
+                    fifoFill -= hopSize;
+                }
+            }
+
+            if (anyNewFrames)
+                publishSpectrum();
+
+            wait (10);
+        }
+    }
+
+    void analyseFrame() noexcept
+    {
+        FloatVectorOperations::multiply (fftData, fifo, window, fftSize);
+        FloatVectorOperations::clear (fftData + fftSize, fftSize);
+
+        fft.performFrequencyOnlyForwardTransform (fftData);
+
+        FloatVectorOperations::multiply (averagedMagnitudes, 1.0f - averagingAmount, numBins);
+        FloatVectorOperations::addWithMultiply (averagedMagnitudes, fftData, averagingAmount, numBins);
+    }
+
+    void publishSpectrum() noexcept
+    {
+        Spectrum spectrum;
+        FloatVectorOperations::copy (spectrum.magnitudes, averagedMagnitudes, numBins);
+        spectrum.sampleRate = sampleRate.load (std::memory_order_relaxed);
+
+        spectrumExchange.push (spectrum);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyser)
+};
+
+
+#endif  // SPECTRUMANALYSER_H_INCLUDED
@@ -19,116 +19,775 @@
 
 
 //==============================================================================
-/** Our demo synth sound is just a basic sine wave.. */
+/** Our demo synth sound is just a basic sine wave..
+
+    In MPE mode, channel 1 is the master channel, which only carries messages that
+    affect all the notes, so the notes themselves are only played on channels 2 to 16.
+*/
 struct SineWaveSound : public SynthesiserSound
 {
-    SineWaveSound() {}
-    
+    SineWaveSound()  : mpeEnabled (false) {}
+
+    /** Only change this with the synth's lock held (see DemoSynth::setMPEEnabled). */
+    void setMPEEnabled (bool shouldBeEnabled) noexcept      { mpeEnabled = shouldBeEnabled; }
+
     bool appliesToNote (int /*midiNoteNumber*/) override        { return true; }
-    bool appliesToChannel (int /*midiChannel*/) override        { return true; }
+    bool appliesToChannel (int midiChannel) override            { return ! mpeEnabled || midiChannel != 1; }
+
+private:
+    bool mpeEnabled;
 };
 
 //==============================================================================
-/** Our demo synth voice just plays a sine wave.. */
+/** The expression data for each MIDI channel, as the synth last received it.
+
+    The DemoSynth writes each pitch wheel, channel pressure and expression
+    controller message straight into here as it arrives, instead of calling
+    every voice that's playing on that channel. Each voice then reads its own
+    channel's values once per chunk of samples that it renders.
+
+    In MPE mode, every note gets a channel to itself, so these become per-note
+    modulation lanes.
+*/
+struct ExpressionLanes
+{
+    ExpressionLanes()  : mpeEnabled (false)
+    {
+        for (int i = 0; i < numChannels; ++i)
+        {
+            pitchBend[i] = pressure[i] = timbre[i] = 0.0f;
+            volume[i] = expression[i] = 1.0f;
+        }
+    }
+
+    enum
+    {
+        numChannels = 16,
+        volumeController = 7,
+        expressionController = 11,
+        timbreController = 74
+    };
+
+    float pitchBend[numChannels];     // -1 to 1
+    float pressure[numChannels];      // 0 to 1, from channel pressure
+    float timbre[numChannels];        // 0 to 1
+    float volume[numChannels];        // 0 to 1
+    float expression[numChannels];    // 0 to 1
+    bool mpeEnabled;
+};
+
+//==============================================================================
+/** Our demo synth voice just plays a sine wave..
+
+    It follows the pitch wheel, channel pressure (which makes it louder), the
+    timbre controller (which blends in some third harmonic), and the channel
+    volume and expression controllers, all of which it reads from the synth's
+    ExpressionLanes. Rather than working out the frequency or level again for
+    every sample, each change starts a short ramp, which gets moved on once per
+    chunk of samples - so when nothing's being moved, it doesn't cost anything.
+*/
 struct SineWaveVoice  : public SynthesiserVoice
 {
-    SineWaveVoice()   : currentAngle (0), angleDelta (0), level (0), tailOff (0)
+    /** The voice settings that can be changed while the synth is playing. */
+    struct Settings
+    {
+        double velocityToLevel = 0.15;
+        double pitchBendRangeSemitones = 2.0;
+        double mpePitchBendRangeSemitones = 48.0;   // for the member channels in MPE mode
+        double pressureToLevel = 1.0;               // full pressure makes the note (1 + this) times louder
+        ADSREnvelope::Parameters envelope;
+    };
+
+    SineWaveVoice()
+        : level (0), noteFrequency (0), lanes (nullptr), midiChannel (1),
+          isBeingRestarted (false), expressionGain (1.0)
     {
     }
+
+    /** This must only be called from the audio thread (see MainComponent::setVoiceSettings). */
+    void setSettings (const Settings& newSettings) noexcept
+    {
+        settings = newSettings;
+        envelope.setParameters (settings.envelope);
+    }
+
+    void setCurrentPlaybackSampleRate (double newRate) override
+    {
+        SynthesiserVoice::setCurrentPlaybackSampleRate (newRate);
+        envelope.setSampleRate (newRate);
+        pitchBend.setRampLength (smoothingSeconds, newRate);
+        expressionGain.setRampLength (smoothingSeconds, newRate);
+        timbre.setRampLength (smoothingSeconds, newRate);
+    }
     
+    // (the DemoSynth knows all its sounds are SineWaveSounds, so it never needs to call this)
     bool canPlaySound (SynthesiserSound* sound) override
     {
         return dynamic_cast<SineWaveSound*> (sound) != nullptr;
     }
     
+    /** The DemoSynth calls this before starting a new note on a voice that's still
+        sounding (because the note's being retriggered, or the voice stolen), so that
+        the Synthesiser's stopNote (0, false) doesn't cut it off. The new note's attack
+        then starts from the gain the old one had got to, and the phase carries on.
+    */
+    void prepareToRestart() noexcept
+    {
+        isBeingRestarted = true;
+    }
+
     void startNote (int midiNoteNumber, float velocity,
                     SynthesiserSound*, int /*currentPitchWheelPosition*/) override
     {
-        currentAngle = 0.0;
-        level = velocity * 0.15;
-        tailOff = 0.0;
-        
-        double cyclesPerSecond = MidiMessage::getMidiNoteInHertz (midiNoteNumber);
-        double cyclesPerSample = cyclesPerSecond / getSampleRate();
-        
-        angleDelta = cyclesPerSample * 2.0 * double_Pi;
+        const float previousGain = level * envelope.getCurrentValue() * (float) expressionGain.getCurrentValue();
+        level = (float) (velocity * settings.velocityToLevel);
+
+        if (isBeingRestarted && level > 0)
+            envelope.noteOn (previousGain / level);
+        else
+            envelope.noteOn();
+
+        noteFrequency = MidiMessage::getMidiNoteInHertz (midiNoteNumber);
+        pitchBend.setValue (0.0);
+        expressionGain.setValue (1.0);
+        timbre.setValue (0.0);
+
+        if (! isBeingRestarted)
+            oscillator.resetPhase();
+
+        oscillator.setFrequency (noteFrequency, getSampleRate());
+        isBeingRestarted = false;
+    }
+
+    /** The DemoSynth calls this straight after starting a note, to tell the voice
+        which channel's expression to follow. The voice jumps to the channel's
+        current values, as anything sent before the note started applies to it.
+    */
+    void startExpression (const ExpressionLanes& lanesToFollow, int channel) noexcept
+    {
+        jassert (isPositiveAndBelow (channel - 1, (int) ExpressionLanes::numChannels));
+
+        lanes = &lanesToFollow;
+        midiChannel = channel;
+
+        updateExpressionTargets();
+
+        for (auto* value : { &pitchBend, &expressionGain, &timbre })
+            value->setValue (value->getTargetValue());
+
+        oscillator.setFrequency (getBentFrequency (pitchBend.getCurrentValue()), getSampleRate());
     }
     
     void stopNote (float /*velocity*/, bool allowTailOff) override
     {
         if (allowTailOff)
         {
-            // start a tail-off by setting this flag. The render callback will pick up on
-            // this and do a fade out, calling clearCurrentNote() when it's finished.
-            
-            if (tailOff == 0.0) // we only need to begin a tail-off if it's not already doing so - the
-                // stopNote method could be called more than once.
-                tailOff = 1.0;
+            // start the envelope's release. The render callback will call clearCurrentNote()
+            // when it's finished (calling this more than once doesn't restart it).
+            envelope.noteOff();
         }
         else
         {
-            // we're being told to stop playing immediately, so reset everything..
+            // we're being told to stop playing immediately, so reset everything - unless
+            // this is just the Synthesiser clearing the way for prepareToRestart()'s new note
             
             clearCurrentNote();
-            angleDelta = 0.0;
+
+            if (! isBeingRestarted)
+                envelope.reset();
         }
     }
     
-    void pitchWheelMoved (int /*newValue*/) override
+    // The DemoSynth doesn't call these: the pitch wheel and the controllers that the
+    // voice cares about go into its ExpressionLanes instead.
+    void pitchWheelMoved (int /*newValue*/) override                        {}
+    void controllerMoved (int /*controllerNumber*/, int /*newValue*/) override  {}
+    
+    void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
     {
-        // can't be bothered implementing this for the demo!
+        // The DemoSynth calls renderMono() directly - this is only used if the voice
+        // is played by some other Synthesiser.
+        float temp[64];
+
+        while (numSamples > 0 && isVoiceActive())
+        {
+            const int num = jmin (numSamples, (int) numElementsInArray (temp));
+            renderMono (temp, num, true);
+
+            for (int i = outputBuffer.getNumChannels(); --i >= 0;)
+                outputBuffer.addFrom (i, startSample, temp, num);
+
+            startSample += num;
+            numSamples -= num;
+        }
     }
-    
-    void controllerMoved (int /*controllerNumber*/, int /*newValue*/) override
+
+    /** Renders the next numSamples of this voice into a single channel. If overwrite
+        is true, the samples replace whatever was in dest (and any samples after the
+        note finishes are zeroed), otherwise they're added to it.
+    */
+    void renderMono (float* dest, int numSamples, bool overwrite) noexcept
     {
-        // not interested in controllers in this case.
+        int i = 0;
+
+        if (envelope.isActive())
+        {
+            // the sine wave and the envelope get worked out a chunk at a time, and then multiplied together
+            float samples[envelopeChunkSize], gains[envelopeChunkSize], ramp[envelopeChunkSize];
+            float harmonic[envelopeChunkSize];
+
+            while (i < numSamples)
+            {
+                const int num = jmin (numSamples - i, (int) envelopeChunkSize);
+                const int numSounding = envelope.getNextBlock (gains, num);
+
+                if (lanes != nullptr)
+                    updateExpressionTargets();
+
+                // if the pitch has been bent, the oscillator glides to where the
+                // bend will have got to by the end of this chunk
+                if (pitchBend.isSmoothing())
+                    oscillator.rampToFrequency (getBentFrequency (pitchBend.getNextValue (numSounding)),
+                                                getSampleRate(), numSounding);
+
+                oscillator.fill (samples, numSounding);
+
+                const float startTimbre = (float) timbre.getCurrentValue();
+                const float endTimbre   = (float) timbre.getNextValue (numSounding);
+
+                if (startTimbre != 0 || endTimbre != 0)
+                    addThirdHarmonic (samples, harmonic, ramp, numSounding, startTimbre, endTimbre);
+
+                // if the level's ramping, the ramp goes into the envelope's gains, and
+                // the output is written the same way as for a steady level
+                const float startLevel = level * (float) expressionGain.getCurrentValue();
+                const float endLevel   = level * (float) expressionGain.getNextValue (numSounding);
+                float outputLevel = startLevel;
+
+                if (startLevel != endLevel)
+                {
+                    fillRamp (ramp, numSounding, startLevel, endLevel);
+                    FloatVectorOperations::multiply (gains, ramp, numSounding);
+                    outputLevel = 1.0f;
+                }
+
+                FloatVectorOperations::multiply (samples, gains, numSounding);
+
+                if (overwrite)
+                    FloatVectorOperations::copyWithMultiply (dest + i, samples, outputLevel, numSounding);
+                else
+                    FloatVectorOperations::addWithMultiply (dest + i, samples, outputLevel, numSounding);
+
+                i += numSounding;
+
+                if (numSounding < num || isInaudible())
+                {
+                    // the release has finished, or the note has faded away to nothing
+                    // (e.g. it's decayed down to a sustain level of zero) - either way,
+                    // there's no point in rendering it any more
+                    clearCurrentNote();
+                    envelope.reset();
+                    break;
+                }
+            }
+        }
+
+        if (overwrite && i < numSamples)
+            FloatVectorOperations::clear (dest + i, numSamples - i);
     }
     
-    void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
+private:
+    enum { envelopeChunkSize = 64 };
+
+    const float inaudibleLevel = 0.0001f;    // -80dB
+    const double smoothingSeconds = 0.01;    // how long the pitch and level take to follow a controller
+
+    // Picks up the latest values from this voice's channel. Each one that has
+    // changed starts a new ramp, and the ones that haven't are left alone.
+    void updateExpressionTargets() noexcept
+    {
+        const ExpressionLanes& e = *lanes;
+        const int ch = midiChannel - 1;
+        const int master = 0;
+
+        double semitones = settings.pitchBendRangeSemitones * e.pitchBend[ch];
+        double gain = e.volume[ch] * e.expression[ch] * (1.0 + settings.pressureToLevel * e.pressure[ch]);
+
+        // in MPE mode, the master channel's bend and volume apply on top of the note's own
+        if (e.mpeEnabled && ch != master)
+        {
+            semitones = settings.pitchBendRangeSemitones * e.pitchBend[master]
+                          + settings.mpePitchBendRangeSemitones * e.pitchBend[ch];
+            gain *= e.volume[master] * e.expression[master];
+        }
+
+        pitchBend.setTarget (semitones);
+        expressionGain.setTarget (gain);
+        timbre.setTarget (e.timbre[ch]);
+    }
+
+    double getBentFrequency (double semitones) const noexcept
+    {
+        return noteFrequency * std::pow (2.0, semitones / 12.0);
+    }
+
+    // Blends a sine wave towards sin (3x), which has the same peak level, using
+    // sin (3x) = 3 sin (x) - 4 sin^3 (x), so the blend adds amount * (2s - 4s^3).
+    // The amount ramps from startAmount to endAmount. The other two buffers are
+    // scratch space, and must hold numSamples.
+    static void addThirdHarmonic (float* samples, float* harmonic, float* amounts, int numSamples,
+                                  float startAmount, float endAmount) noexcept
     {
-        if (angleDelta != 0.0)
+        FloatVectorOperations::multiply (harmonic, samples, samples, numSamples);
+        FloatVectorOperations::multiply (harmonic, samples, numSamples);
+        FloatVectorOperations::multiply (harmonic, -4.0f, numSamples);
+        FloatVectorOperations::addWithMultiply (harmonic, samples, 2.0f, numSamples);
+
+        if (startAmount != endAmount)
+        {
+            fillRamp (amounts, numSamples, startAmount, endAmount);
+            FloatVectorOperations::multiply (harmonic, amounts, numSamples);
+            FloatVectorOperations::add (samples, harmonic, numSamples);
+        }
+        else
         {
-            if (tailOff > 0)
+            FloatVectorOperations::addWithMultiply (samples, harmonic, startAmount, numSamples);
+        }
+    }
+
+    // Fills dest with a straight line from startValue towards endValue (which
+    // would be the sample after the last one).
+    static void fillRamp (float* dest, int numSamples, float startValue, float endValue) noexcept
+    {
+        const float step = (endValue - startValue) / numSamples;
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = startValue + step * (float) i;
+    }
+
+    // (the attack starts from zero, so a note can't be culled until it's had a chance to get going,
+    // and the expression gain counts at whichever end of its ramp is louder)
+    bool isInaudible() const noexcept
+    {
+        const float gain = (float) jmax (expressionGain.getCurrentValue(), expressionGain.getTargetValue());
+        return ! envelope.isInAttack() && level * envelope.getCurrentValue() * gain < inaudibleLevel;
+    }
+
+    float level;
+    double noteFrequency;
+    const ExpressionLanes* lanes;
+    int midiChannel;
+    bool isBeingRestarted;
+    Settings settings;
+    SineOscillator oscillator;
+    ADSREnvelope envelope;
+    SmoothedValue pitchBend, expressionGain, timbre;
+};
+
+
+//==============================================================================
+/** A Synthesiser that knows all its voices are SineWaveVoices, and renders them
+    into a single channel.
+
+    Rather than clearing the buffer and then having every voice add itself to it,
+    the first active voice overwrites the buffer, and only the others add to it.
+    If no voices are playing, the buffer just gets cleared.
+
+    The voices can also be spread across several threads - see setNumRenderThreads(),
+    and rendered at a multiple of the sample rate to stop richer waveforms from
+    aliasing - see setOversampling().
+
+    Because it knows the types of all its sounds and voices, it can start notes
+    without asking each voice whether it can play the sound, and a VoiceAllocator
+    finds the voice for each new note (or the one to steal) without searching.
+
+    The synthesiser normally splits the block wherever there's a MIDI event, so
+    busy MIDI input can chop it into lots of tiny renders. renderNextBlockQuantised()
+    moves the events to sub-block boundaries first (see setMidiQuantisation()).
+
+    Pitch wheel, channel pressure and the controllers the voices use are written
+    into a table of ExpressionLanes, rather than being passed to each voice, and
+    it can treat the channels as an MPE zone - see setMPEEnabled().
+*/
+struct DemoSynth  : public Synthesiser
+{
+    DemoSynth()  : midiQuantum (1)
+    {
+        quantisedMidi.ensureSize (2048);
+    }
+
+    /** Add all the sounds and voices before the audio starts. */
+    void addSineSound (SineWaveSound* sound)
+    {
+        addSound (sound);
+        sineSounds.add (sound);
+    }
+
+    SineWaveVoice* addSineVoice()
+    {
+        const ScopedLock sl (lock);
+
+        SineWaveVoice* voice = new SineWaveVoice();
+        addVoice (voice);
+        sineVoices.add (voice);
+        activeVoices.ensureStorageAllocated (sineVoices.size());
+        allocator.setNumVoices (sineVoices.size());
+        return voice;
+    }
+
+    const Array<SineWaveVoice*>& getSineVoices() const noexcept     { return sineVoices; }
+
+    /** Returns true if any voices are still sounding. Only call this from the audio thread.
+        When there aren't any and there's no MIDI coming in, the output is going to be
+        silent, so the caller doesn't need to render anything at all.
+    */
+    bool isAnyVoicePlaying() const noexcept
+    {
+        // (any voices that finished in the last block will still be in the active
+        // list, but it only ever has to look past those to find a playing one)
+        for (int index = allocator.getOldest(); index >= 0; index = allocator.getNextNewer (index))
+            if (sineVoices.getUnchecked (index)->isVoiceActive())
+                return true;
+
+        return false;
+    }
+
+    /** Renders the voices on this many threads, counting the audio thread (so 1 means
+        no extra threads). Blocks bigger than maximumBlockSize are always rendered on
+        the audio thread alone. Don't call this from the audio thread!
+    */
+    void setNumRenderThreads (int numThreads, int maximumBlockSize)
+    {
+        ScopedPointer<VoiceRenderPool<SineWaveVoice>> newPool;
+
+        // (the pool's buffers are made big enough for the highest oversampling factor)
+        if (numThreads > 1)
+            newPool = new VoiceRenderPool<SineWaveVoice> (numThreads - 1, maximumBlockSize * Oversampler::maxFactor);
+
+        {
+            const ScopedLock sl (lock);
+            renderPool.swapWith (newPool);
+        }
+
+        // (the old pool gets deleted here, outside the lock)
+    }
+
+    /** Makes the voices render at 1, 2, 4 or 8 times the playback sample rate, and
+        filters their output back down to it. maximumBlockSize is the largest block
+        (at the playback rate) that will be rendered. Any notes that are playing get
+        stopped. Don't call this from the audio thread!
+    */
+    void setOversampling (int factor, int maximumBlockSize)
+    {
+        ScopedPointer<Oversampler> newOversampler;
+
+        if (factor > 1)
+            newOversampler = new Oversampler (factor, maximumBlockSize);
+
+        {
+            const ScopedLock sl (lock);
+            allNotesOff (0, false);
+            oversampler.swapWith (newOversampler);
+            updateVoiceSampleRates();
+        }
+    }
+
+    int getOversamplingFactor() const noexcept
+    {
+        return oversampler != nullptr ? oversampler->getFactor() : 1;
+    }
+
+    void setCurrentPlaybackSampleRate (double newRate) override
+    {
+        Synthesiser::setCurrentPlaybackSampleRate (newRate);
+
+        const ScopedLock sl (lock);
+        updateVoiceSampleRates();
+    }
+
+    //==========================================================================
+    /** Sets the sub-block size used by renderNextBlockQuantised(). Each event gets
+        moved back to the start of the sub-block it falls in, so the voices always
+        render at least this many samples at a time. 1 keeps events sample-accurate.
+    */
+    void setMidiQuantisation (int numSamples) noexcept
+    {
+        midiQuantum = jmax (1, numSamples);
+    }
+
+    /** The same as renderNextBlock(), but with the events' positions quantised. */
+    void renderNextBlockQuantised (AudioSampleBuffer& outputAudio, const MidiBuffer& inputMidi,
+                                   int startSample, int numSamples)
+    {
+        if (midiQuantum <= 1)
+        {
+            renderNextBlock (outputAudio, inputMidi, startSample, numSamples);
+            return;
+        }
+
+        quantisedMidi.clear();
+
+        MidiBuffer::Iterator i (inputMidi);
+        i.setNextSamplePosition (startSample);
+
+        const uint8* midiData;
+        int numBytes, samplePosition;
+
+        // (the events stay in the same order, as addEvent puts each one after
+        // any others that are already at the same position)
+        while (i.getNextEvent (midiData, numBytes, samplePosition))
+            quantisedMidi.addEvent (midiData, numBytes,
+                                    startSample + ((samplePosition - startSample) / midiQuantum) * midiQuantum);
+
+        renderNextBlock (outputAudio, quantisedMidi, startSample, numSamples);
+    }
+
+    //==========================================================================
+    void noteOn (int midiChannel, int midiNoteNumber, float velocity) override
+    {
+        const ScopedLock sl (lock);
+
+        for (auto* sound : sineSounds)
+        {
+            if (sound->appliesToNote (midiNoteNumber) && sound->appliesToChannel (midiChannel))
             {
-                while (--numSamples >= 0)
+                // If hitting a note that's still ringing (it could be still playing because
+                // of the sustain or sostenuto pedal), the same voice plays it again.
+                int index = allocator.getVoiceForNote (midiChannel, midiNoteNumber);
+
+                if (index >= 0)
+                {
+                    SineWaveVoice* voice = sineVoices.getUnchecked (index);
+
+                    if (voice->getCurrentlyPlayingNote() == midiNoteNumber && voice->isPlayingChannel (midiChannel))
+                        allocator.moveToNewest (index);
+                    else
+                        index = -1;
+                }
+
+                if (index < 0)
+                    index = allocateVoice();
+
+                if (index >= 0)
                 {
-                    const float currentSample = (float) (std::sin (currentAngle) * level * tailOff);
-                    
-                    for (int i = outputBuffer.getNumChannels(); --i >= 0;)
-                        outputBuffer.addSample (i, startSample, currentSample);
-                    
-                    currentAngle += angleDelta;
-                    ++startSample;
-                    
-                    tailOff *= 0.99;
-                    
-                    if (tailOff <= 0.005)
-                    {
-                        clearCurrentNote();
-                        
-                        angleDelta = 0.0;
-                        break;
-                    }
+                    SineWaveVoice* voice = sineVoices.getUnchecked (index);
+
+                    // a retriggered or stolen voice carries on from where it is, rather
+                    // than being cut off and starting again from silence
+                    if (voice->isVoiceActive())
+                        voice->prepareToRestart();
+
+                    startVoice (voice, sound, midiChannel, midiNoteNumber, velocity);
+                    allocator.setVoiceForNote (midiChannel, midiNoteNumber, index);
+
+                    if (isPositiveAndBelow (midiChannel - 1, (int) ExpressionLanes::numChannels))
+                        voice->startExpression (expressionLanes, midiChannel);
                 }
             }
-            else
+        }
+    }
+
+    /** In MPE mode, channel 1 is the master channel, and each note is played on one
+        of the member channels, 2 to 16, whose pitch bend, channel pressure and timbre
+        (CC74) only affect that note. The master channel's pitch bend and volume
+        affect all the notes. Any notes that are playing get stopped.
+    */
+    void setMPEEnabled (bool shouldBeEnabled)
+    {
+        const ScopedLock sl (lock);
+
+        allNotesOff (0, false);
+        expressionLanes.mpeEnabled = shouldBeEnabled;
+
+        for (auto* sound : sineSounds)
+            sound->setMPEEnabled (shouldBeEnabled);
+    }
+
+protected:
+    // The expression messages get stored straight into the lanes, where the voices
+    // will pick them up - anything else goes to the Synthesiser as usual.
+    void handleMidiEvent (const MidiMessage& m) override
+    {
+        const int channelIndex = m.getChannel() - 1;
+
+        if (isPositiveAndBelow (channelIndex, (int) ExpressionLanes::numChannels))
+        {
+            ExpressionLanes& e = expressionLanes;
+
+            if (m.isPitchWheel())
+            {
+                e.pitchBend[channelIndex] = (m.getPitchWheelValue() - 8192) / 8192.0f;
+                return;
+            }
+
+            if (m.isChannelPressure())
+            {
+                e.pressure[channelIndex] = m.getChannelPressureValue() / 127.0f;
+                return;
+            }
+
+            if (m.isController())
             {
-                while (--numSamples >= 0)
+                const float value = m.getControllerValue() / 127.0f;
+
+                switch (m.getControllerNumber())
                 {
-                    const float currentSample = (float) (std::sin (currentAngle) * level);
-                    
-                    for (int i = outputBuffer.getNumChannels(); --i >= 0;)
-                        outputBuffer.addSample (i, startSample, currentSample);
-                    
-                    currentAngle += angleDelta;
-                    ++startSample;
+                    case ExpressionLanes::volumeController:      e.volume[channelIndex] = value;      return;
+                    case ExpressionLanes::expressionController:  e.expression[channelIndex] = value;  return;
+                    case ExpressionLanes::timbreController:      e.timbre[channelIndex] = value;      return;
+                    default: break;
                 }
             }
         }
+
+        Synthesiser::handleMidiEvent (m);
     }
-    
+
+    /** Only the buffer's first channel gets rendered - it's up to the caller to copy
+        it to any other channels.
+    */
+    void renderVoices (AudioSampleBuffer& buffer, int startSample, int numSamples) override
+    {
+        float* const dest = buffer.getWritePointer (0, startSample);
+
+        // Collect the active voices, oldest first, and hand any that have
+        // finished since the last block back to the allocator.
+        releaseFinishedVoices();
+        activeVoices.clearQuick();
+
+        for (int index = allocator.getOldest(); index >= 0; index = allocator.getNextNewer (index))
+            activeVoices.add (sineVoices.getUnchecked (index));
+
+        if (oversampler == nullptr)
+        {
+            renderActiveVoices (dest, numSamples);
+            return;
+        }
+
+        // The voices render at the higher rate, as much at a time as the oversampler
+        // can take, and then it filters that back down to the playback rate.
+        const int factor = oversampler->getFactor();
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            const int num = jmin (numSamples - pos, oversampler->getMaximumBlockSize());
+
+            renderActiveVoices (oversampler->getInputBuffer(), num * factor);
+            oversampler->process (dest + pos, num);
+            pos += num;
+        }
+
+        // If every voice has now finished, the audio callback may stop rendering
+        // altogether, so the filters' history is cleared rather than left to come
+        // out at the start of the next note. (The voices only finish once they're
+        // inaudible, so there's nothing to hear in it anyway.)
+        bool anyStillPlaying = false;
+
+        for (auto* voice : activeVoices)
+            anyStillPlaying = anyStillPlaying || voice->isVoiceActive();
+
+        if (! anyStillPlaying)
+            oversampler->reset();
+    }
+
 private:
-    double currentAngle, angleDelta, level, tailOff;
+    //==========================================================================
+    // Writes the sum of the active voices into dest.
+    void renderActiveVoices (float* dest, int numSamples) noexcept
+    {
+        if (renderPool != nullptr && activeVoices.size() > 1
+             && numSamples <= renderPool->getMaximumBlockSize())
+        {
+            renderPool->render (activeVoices.getRawDataPointer(), activeVoices.size(), dest, numSamples);
+            return;
+        }
+
+        bool isFirstVoice = true;
+
+        for (auto* voice : activeVoices)
+        {
+            voice->renderMono (dest, numSamples, isFirstVoice);
+            isFirstVoice = false;
+        }
+
+        if (isFirstVoice)
+            FloatVectorOperations::clear (dest, numSamples);
+    }
+
+    // The voices run at the oversampled rate, so they need to know what that is.
+    // This must be called with the lock held.
+    void updateVoiceSampleRates()
+    {
+        for (auto* voice : sineVoices)
+            voice->setCurrentPlaybackSampleRate (getSampleRate() * getOversamplingFactor());
+    }
+
+    // Returns a free voice if there is one, otherwise the one to steal (or -1 if
+    // stealing is turned off), and makes it the newest active voice.
+    int allocateVoice() noexcept
+    {
+        int index = allocator.allocate();
+
+        if (index < 0)
+        {
+            // Voices that finished in the last block are still in the active list
+            // until the next render - and most notes start before that, at the
+            // beginning of the block - so free those before stealing anything.
+            releaseFinishedVoices();
+            index = allocator.allocate();
+        }
+
+        if (index >= 0 || ! isNoteStealingEnabled())
+            return index;
+
+        // Every voice is still sounding, so steal the oldest one - unless its key is
+        // still held and one of the next few oldest has been released, in which
+        // case take that one instead.
+        int toSteal = allocator.getOldest();
+
+        for (int i = toSteal, numChecked = 0; i >= 0 && numChecked < maxVoicesToCheckWhenStealing;
+             i = allocator.getNextNewer (i), ++numChecked)
+        {
+            if (! isHeld (sineVoices.getUnchecked (i)) && isHeld (sineVoices.getUnchecked (toSteal)))
+                toSteal = i;
+        }
+
+        if (toSteal >= 0)
+            allocator.moveToNewest (toSteal);
+
+        return toSteal;
+    }
+
+    // Moves any voices that have stopped sounding from the active list to the free list.
+    void releaseFinishedVoices() noexcept
+    {
+        for (int index = allocator.getOldest(); index >= 0;)
+        {
+            const int next = allocator.getNextNewer (index);
+
+            if (! sineVoices.getUnchecked (index)->isVoiceActive())
+                allocator.release (index);
+
+            index = next;
+        }
+    }
+
+    static bool isHeld (const SineWaveVoice* voice) noexcept
+    {
+        return voice->isKeyDown() || voice->isSustainPedalDown();
+    }
+
+    enum { maxVoicesToCheckWhenStealing = 4 };
+
+    int midiQuantum;
+    MidiBuffer quantisedMidi;
+    ExpressionLanes expressionLanes;
+
+    Array<SineWaveSound*> sineSounds;
+    Array<SineWaveVoice*> sineVoices, activeVoices;
+    VoiceAllocator allocator;
+    ScopedPointer<VoiceRenderPool<SineWaveVoice>> renderPool;
+    ScopedPointer<Oversampler> oversampler;
 };
 
 
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SYNTHBENCHMARK_H_INCLUDED
+#define SYNTHBENCHMARK_H_INCLUDED
+
+/* Times how long the DemoSynth takes to render with each oversampling factor,
+   without an audio device. Launch the app with --benchmark-oversampling to run
+   it and log the results.
+
+   For each factor, it reports the time taken by the whole synth (the voices
+   plus the filters) and by the filters on their own, per second of audio.
+*/
+struct SynthBenchmark
+{
+    static String runOversamplingBenchmark()
+    {
+        const double sampleRate = 44100.0;
+        const double secondsOfAudio = 10.0;
+        const int blockSize = 512;
+        const int numVoices = 16;
+        const int numBlocks = roundToInt (secondsOfAudio * sampleRate / blockSize);
+
+        String results;
+        results << "Oversampling benchmark: " << numVoices << " voices, "
+                << blockSize << " sample blocks at " << sampleRate << "Hz" << newLine;
+
+        for (int factor = 1; factor <= Oversampler::maxFactor; factor *= 2)
+        {
+            DemoSynth synth;
+            synth.addSineSound (new SineWaveSound());
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addSineVoice();
+
+            synth.setCurrentPlaybackSampleRate (sampleRate);
+            synth.setOversampling (factor, blockSize);
+
+            // (the default envelope sustains at full level, so these keep going)
+            for (int i = 0; i < numVoices; ++i)
+                synth.noteOn (1, 48 + 2 * i, 0.8f);
+
+            AudioBuffer<float> buffer (1, blockSize);
+            const MidiBuffer noMidi;
+
+            const double synthMs = timeBlocks (numBlocks, [&]
+            {
+                synth.renderNextBlock (buffer, noMidi, 0, blockSize);
+            });
+
+            double filterMs = 0;
+
+            if (factor > 1)
+            {
+                Oversampler oversampler (factor, blockSize);
+
+                filterMs = timeBlocks (numBlocks, [&]
+                {
+                    FloatVectorOperations::fill (oversampler.getInputBuffer(), 0.1f, blockSize * factor);
+                    oversampler.process (buffer.getWritePointer (0), blockSize);
+                });
+            }
+
+            results << factor << "x: " << String (synthMs / secondsOfAudio, 3) << "ms per second of audio ("
+                    << String (filterMs / secondsOfAudio, 3) << "ms in the filters)" << newLine;
+        }
+
+        return results;
+    }
+
+private:
+    // Returns the number of milliseconds taken to call renderBlock numBlocks times,
+    // after one call to warm up.
+    template <typename RenderFunction>
+    static double timeBlocks (int numBlocks, RenderFunction renderBlock)
+    {
+        renderBlock();
+
+        const double startTime = Time::getMillisecondCounterHiRes();
+
+        for (int i = 0; i < numBlocks; ++i)
+            renderBlock();
+
+        return Time::getMillisecondCounterHiRes() - startTime;
+    }
+};
+
+
+#endif  // SYNTHBENCHMARK_H_INCLUDED
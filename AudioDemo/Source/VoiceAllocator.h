@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef VOICEALLOCATOR_H_INCLUDED
+#define VOICEALLOCATOR_H_INCLUDED
+
+/* Keeps track of which of a synth's voices are free and which are playing,
+   so that finding a voice for a new note never has to look through them all.
+
+   Voices are referred to by their index. Each one is in exactly one of two
+   lists: the free list, or the active list, which is kept in the order the
+   voices were started, oldest first. Both are doubly-linked through a pair
+   of index arrays, so moving a voice from one to the other is O(1).
+
+   It also remembers which voice was last started for each note on each
+   MIDI channel, so that retriggering a note doesn't need a search either.
+*/
+class VoiceAllocator
+{
+public:
+    VoiceAllocator()  : numVoices (0), nextInList (2), prevInList (2)
+    {
+        for (int list : { freeList(), activeList() })
+            nextInList[list] = prevInList[list] = list;
+
+        clearNoteTable();
+    }
+
+    /** Adds voices to bring the total up to newNumVoices, putting the new ones in
+        the free list. Voices that are already playing stay where they are, and
+        so do the notes they're playing - the number of voices can only grow.
+    */
+    void setNumVoices (int newNumVoices)
+    {
+        jassert (newNumVoices >= numVoices);
+
+        // the ends of the lists move up to make room, so the links get copied across
+        const int oldNumVoices = numVoices;
+        HeapBlock<int> newNext ((size_t) newNumVoices + 2), newPrev ((size_t) newNumVoices + 2);
+
+        for (int i = 0; i < oldNumVoices + 2; ++i)
+        {
+            const int newIndex = moveIndex (i, oldNumVoices, newNumVoices);
+            newNext[newIndex] = moveIndex (nextInList[i], oldNumVoices, newNumVoices);
+            newPrev[newIndex] = moveIndex (prevInList[i], oldNumVoices, newNumVoices);
+        }
+
+        nextInList.swapWith (newNext);
+        prevInList.swapWith (newPrev);
+        numVoices = newNumVoices;
+
+        for (int i = oldNumVoices; i < numVoices; ++i)
+            insertAtEnd (i, freeList());
+    }
+
+    //==========================================================================
+    /** Takes a voice from the free list and moves it to the newest end of the
+        active list. Returns -1 if there aren't any free voices.
+    */
+    int allocate() noexcept
+    {
+        const int index = nextInList[freeList()];
+
+        if (index == freeList())
+            return -1;
+
+        moveToNewest (index);
+        return index;
+    }
+
+    /** Moves a voice (which may already be active) to the newest end of the active list. */
+    void moveToNewest (int index) noexcept
+    {
+        jassert (isPositiveAndBelow (index, numVoices));
+        unlink (index);
+        insertAtEnd (index, activeList());
+    }
+
+    /** Moves a voice back into the free list. */
+    void release (int index) noexcept
+    {
+        jassert (isPositiveAndBelow (index, numVoices));
+        unlink (index);
+        insertAtEnd (index, freeList());
+    }
+
+    //==========================================================================
+    /** Returns the oldest active voice, or -1 if none are active. */
+    int getOldest() const noexcept
+    {
+        const int index = nextInList[activeList()];
+        return index != activeList() ? index : -1;
+    }
+
+    /** Returns the next newer active voice after this one, or -1 if it's the newest. */
+    int getNextNewer (int index) const noexcept
+    {
+        const int next = nextInList[index];
+        return next != activeList() ? next : -1;
+    }
+
+    //==========================================================================
+    /** Returns the voice that was last started on this note and channel, or -1. */
+    int getVoiceForNote (int midiChannel, int midiNoteNumber) const noexcept
+    {
+        return isValidNote (midiChannel, midiNoteNumber) ? noteTable[midiChannel - 1][midiNoteNumber] : -1;
+    }
+
+    void setVoiceForNote (int midiChannel, int midiNoteNumber, int index) noexcept
+    {
+        if (isValidNote (midiChannel, midiNoteNumber))
+            noteTable[midiChannel - 1][midiNoteNumber] = (int16) index;
+    }
+
+private:
+    //==========================================================================
+    int numVoices;
+
+    // the two extra entries at the end are the start (and end) of each list
+    HeapBlock<int> nextInList, prevInList;
+
+    int16 noteTable[16][128];
+
+    int freeList() const noexcept       { return numVoices; }
+    int activeList() const noexcept     { return numVoices + 1; }
+
+    void unlink (int index) noexcept
+    {
+        nextInList[prevInList[index]] = nextInList[index];
+        prevInList[nextInList[index]] = prevInList[index];
+    }
+
+    void insertAtEnd (int index, int list) noexcept
+    {
+        const int last = prevInList[list];
+        nextInList[last] = index;
+        prevInList[index] = last;
+        nextInList[index] = list;
+        prevInList[list] = index;
+    }
+
+    // Where an index in the link arrays ends up when the number of voices changes.
+    static int moveIndex (int index, int oldNumVoices, int newNumVoices) noexcept
+    {
+        return index < oldNumVoices ? index : index - oldNumVoices + newNumVoices;
+    }
+
+    static bool isValidNote (int midiChannel, int midiNoteNumber) noexcept
+    {
+        return isPositiveAndBelow (midiChannel - 1, 16) && isPositiveAndBelow (midiNoteNumber, 128);
+    }
+
+    void clearNoteTable() noexcept
+    {
+        for (auto& channel : noteTable)
+            for (auto& voice : channel)
+                voice = -1;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (VoiceAllocator)
+};
+
+
+#endif  // VOICEALLOCATOR_H_INCLUDED
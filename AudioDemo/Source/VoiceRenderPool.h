@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for
+   the JUCE Summit 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef VOICERENDERPOOL_H_INCLUDED
+#define VOICERENDERPOOL_H_INCLUDED
+
+/* Spreads the rendering of a block of voices across some worker threads.
+
+   The voices are dealt out into groups, one per thread. The audio thread
+   renders the first group straight into the output, and the others get
+   claimed by whichever thread gets to them first (which may be the audio
+   thread itself, if a worker is slow to wake up) and rendered into their own
+   partial mixes. When they've all finished, the audio thread adds the partial
+   mixes into the output.
+
+   The threads are kicked off and waited for with atomic counters rather than
+   locks, and the audio thread only ever waits for groups that another thread
+   has already started rendering - any that haven't been started by the time
+   it's finished its own, it takes over.
+
+   The workers run at the highest thread priority (which is real-time, round-
+   robin scheduling on Linux and OSX). Between callbacks they keep polling for
+   the next job, yielding each time round, for maxSpinMilliseconds - longer
+   than the period of any normal block size - so while the audio is running
+   they're always awake, and starting them is just an atomic increment. Only
+   once there's been no work for that long do they go to sleep on an event.
+   Then the first callback after that has to signal them, which does mean a
+   call into the OS, but it doesn't wait for them to wake up.
+
+   VoiceType must have a method renderMono (float* dest, int numSamples, bool overwrite),
+   which can safely be called on one voice while other voices render on other threads.
+*/
+template <typename VoiceType>
+class VoiceRenderPool
+{
+public:
+    //==========================================================================
+    VoiceRenderPool (int numWorkerThreads, int maximumBlockSize)
+        : partialMixes (jmax (1, numWorkerThreads), maximumBlockSize),
+          generation (0), nextGroup (numWorkerThreads + 1), numGroupsFinished (0), numSleeping (0),
+          jobVoices (nullptr), jobNumVoices (0), jobNumSamples (0)
+    {
+        groupHadVoices.calloc ((size_t) numWorkerThreads + 1);
+
+        for (int i = 0; i < numWorkerThreads; ++i)
+            workers.add (new Worker (*this));
+
+        for (auto* w : workers)
+            w->startThread (10);
+    }
+
+    ~VoiceRenderPool()
+    {
+        for (auto* w : workers)
+            w->signalThreadShouldExit();
+
+        for (auto* w : workers)
+        {
+            w->wakeUp.signal();
+            w->stopThread (1000);
+        }
+    }
+
+    int getNumThreads() const noexcept          { return workers.size() + 1; }
+    int getMaximumBlockSize() const noexcept    { return partialMixes.getNumSamples(); }
+
+    //==========================================================================
+    /** Called by the audio thread: renders all the voices, and writes (rather than
+        adds) their sum into dest. Returns when every voice has finished rendering.
+    */
+    void render (VoiceType* const* voices, int numVoices, float* dest, int numSamples) noexcept
+    {
+        jassert (numSamples <= getMaximumBlockSize());
+
+        jobVoices = voices;
+        jobNumVoices = numVoices;
+        jobNumSamples = numSamples;
+
+        numGroupsFinished.store (0, std::memory_order_relaxed);
+        nextGroup.store (1, std::memory_order_release);        // this opens the job's groups up for claiming..
+        generation.fetch_add (1, std::memory_order_seq_cst);  // ..and this tells the workers about it
+
+        if (numSleeping.load (std::memory_order_seq_cst) > 0)
+            for (auto* w : workers)
+                w->wakeUp.signal();
+
+        renderGroup (0, dest);
+        claimAndRenderGroups();
+
+        // the barrier: wait for any groups that the workers are still rendering,
+        // without ever going to sleep
+        while (numGroupsFinished.load (std::memory_order_acquire) < workers.size())
+            Thread::yield();
+
+        for (int group = 1; group < getNumThreads(); ++group)
+            if (groupHadVoices[group])
+                FloatVectorOperations::add (dest, partialMixes.getReadPointer (group - 1), numSamples);
+    }
+
+private:
+    //==========================================================================
+    struct Worker  : public Thread
+    {
+        Worker (VoiceRenderPool& p)
+            : Thread ("Voice Renderer"), pool (p)
+        {
+        }
+
+        void run() override
+        {
+            uint32 lastGeneration = pool.generation.load (std::memory_order_acquire);
+            double lastJobTime = Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                const uint32 newGeneration = pool.generation.load (std::memory_order_acquire);
+
+                if (newGeneration != lastGeneration)
+                {
+                    lastGeneration = newGeneration;
+                    pool.claimAndRenderGroups();
+                    lastJobTime = Time::getMillisecondCounterHiRes();
+                }
+                else if (Time::getMillisecondCounterHiRes() - lastJobTime < maxSpinMilliseconds)
+                {
+                    Thread::yield();
+                }
+                else
+                {
+                    // announce that we're going to sleep, then check again, so that
+                    // either we see the new job, or the audio thread sees us sleeping
+                    pool.numSleeping.fetch_add (1, std::memory_order_seq_cst);
+
+                    if (pool.generation.load (std::memory_order_seq_cst) == lastGeneration)
+                        wakeUp.wait (100);
+
+                    pool.numSleeping.fetch_sub (1, std::memory_order_seq_cst);
+                    lastJobTime = Time::getMillisecondCounterHiRes();
+                }
+            }
+        }
+
+        VoiceRenderPool& pool;
+        WaitableEvent wakeUp;
+
+        // (a 2048-sample block at 44.1kHz lasts about 46ms)
+        enum { maxSpinMilliseconds = 50 };
+
+        JUCE_DECLARE_NON_COPYABLE (Worker)
+    };
+
+    // Keeps claiming groups of the current job and rendering them into their
+    // partial mixes, until there are none left.
+    void claimAndRenderGroups() noexcept
+    {
+        for (;;)
+        {
+            const int group = nextGroup.fetch_add (1, std::memory_order_acq_rel);
+
+            if (group >= getNumThreads())
+                break;
+
+            groupHadVoices[group] = renderGroup (group, partialMixes.getWritePointer (group - 1));
+            numGroupsFinished.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+    // Renders every getNumThreads()'th voice, starting at groupIndex, into dest.
+    // The first one overwrites dest, and the rest add to it. Returns false (and
+    // leaves dest alone) if there weren't any voices in the group.
+    bool renderGroup (int groupIndex, float* dest) noexcept
+    {
+        const int stride = getNumThreads();
+        bool isFirstVoice = true;
+
+        for (int i = groupIndex; i < jobNumVoices; i += stride)
+        {
+            jobVoices[i]->renderMono (dest, jobNumSamples, isFirstVoice);
+            isFirstVoice = false;
+        }
+
+        if (isFirstVoice && groupIndex == 0)
+            FloatVectorOperations::clear (dest, jobNumSamples);
+
+        return ! isFirstVoice;
+    }
+
+    //==========================================================================
+    OwnedArray<Worker> workers;
+    AudioBuffer<float> partialMixes;
+
+    std::atomic<uint32> generation;
+    std::atomic<int> nextGroup, numGroupsFinished, numSleeping;
+    HeapBlock<bool> groupHadVoices;
+
+    // the current job - these are written by the audio thread before it opens up
+    // the groups, and only read by a thread that has claimed one of them
+    VoiceType* const* jobVoices;
+    int jobNumVoices, jobNumSamples;
+
+    JUCE_DECLARE_NON_COPYABLE (VoiceRenderPool)
+};
+
+
+#endif  // VOICERENDERPOOL_H_INCLUDED
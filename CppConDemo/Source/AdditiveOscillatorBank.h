@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef ADDITIVEOSCILLATORBANK_H_INCLUDED
+#define ADDITIVEOSCILLATORBANK_H_INCLUDED
+
+
+//==============================================================================
+/* Renders a sum of sine partials that all follow the same base phase.
+
+   Instead of calling std::sin for every partial on every sample, each partial
+   is a recursive (rotating phasor) oscillator: sin and cos are evaluated once
+   per partial at the start of the block, and after that every sample only
+   needs a few multiply-adds. The partials are kept in flat arrays so the
+   compiler can vectorise the per-sample loop across them.
+
+   The phasors get re-seeded from the exact phase at the start of every block,
+   so rounding errors can't build up over time. A partial's amplitude can be
+   given for both ends of the block, in which case it is ramped linearly.
+
+   The base frequency can glide across a block too. Then each partial's
+   per-sample rotation is itself rotated a little further on every sample, so
+   the phase increment changes linearly instead of jumping once per block.
+   That second rotation is done in double precision, as its rounding errors
+   would otherwise add up twice over (once into the increment, and again
+   into the phase).
+*/
+class AdditiveOscillatorBank
+{
+public:
+    AdditiveOscillatorBank()  : numPartials (0) {}
+
+    //==========================================================================
+    void clearPartials() noexcept
+    {
+        numPartials = 0;
+    }
+
+    /** Adds a partial at frequencyRatio times the base frequency.
+        Partials beyond maxPartials are ignored.
+    */
+    void addPartial (double frequencyRatio, float amplitude) noexcept
+    {
+        addPartial (frequencyRatio, amplitude, amplitude);
+    }
+
+    /** Adds a partial whose amplitude moves from startAmplitude to endAmplitude
+        over the next rendered block.
+    */
+    void addPartial (double frequencyRatio, float startAmplitude, float endAmplitude) noexcept
+    {
+        if (numPartials < maxPartials)
+        {
+            ratios[numPartials] = frequencyRatio;
+            amplitudes[numPartials] = startAmplitude;
+            endAmplitudes[numPartials] = endAmplitude;
+            ++numPartials;
+        }
+    }
+
+    int getNumPartials() const noexcept     { return numPartials; }
+
+    //==========================================================================
+    /** Writes (rather than adds) numSamples of the summed partials into output,
+        and advances the phase by numSamples * phaseDelta.
+    */
+    void render (float* output, int numSamples, double& phase, double phaseDelta) noexcept
+    {
+        render (output, numSamples, phase, phaseDelta, phaseDelta);
+    }
+
+    /** Like the other render(), but with the phase increment gliding linearly from
+        startPhaseDelta to endPhaseDelta across the block. The next block should
+        start from endPhaseDelta, so the pitch never jumps at the block boundary.
+    */
+    void render (float* output, int numSamples, double& phase,
+                 double startPhaseDelta, double endPhaseDelta) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const double deltaStep = (endPhaseDelta - startPhaseDelta) / numSamples;
+
+        for (int k = 0; k < numPartials; ++k)
+        {
+            sinValues[k] = (float) std::sin (phase * ratios[k]);
+            cosValues[k] = (float) std::cos (phase * ratios[k]);
+            sinDeltas[k] = (float) std::sin (startPhaseDelta * ratios[k]);
+            cosDeltas[k] = (float) std::cos (startPhaseDelta * ratios[k]);
+            sinGlideDeltas[k] = std::sin (startPhaseDelta * ratios[k]);
+            cosGlideDeltas[k] = std::cos (startPhaseDelta * ratios[k]);
+            sinDeltaSteps[k] = std::sin (deltaStep * ratios[k]);
+            cosDeltaSteps[k] = std::cos (deltaStep * ratios[k]);
+            amplitudeSteps[k] = (endAmplitudes[k] - amplitudes[k]) / numSamples;
+        }
+
+        if (deltaStep == 0.0)
+            renderPartials<false> (output, numSamples);
+        else
+            renderPartials<true> (output, numSamples);
+
+        // (sample i moved on by startPhaseDelta + i * deltaStep)
+        phase += numSamples * startPhaseDelta + deltaStep * numSamples * (numSamples - 1) * 0.5;
+    }
+
+private:
+    //==========================================================================
+    enum { maxPartials = 64 };
+
+    int numPartials;
+    double ratios[maxPartials];
+    float amplitudes[maxPartials], endAmplitudes[maxPartials], amplitudeSteps[maxPartials];
+    float sinValues[maxPartials], cosValues[maxPartials];
+    float sinDeltas[maxPartials], cosDeltas[maxPartials];
+    double sinGlideDeltas[maxPartials], cosGlideDeltas[maxPartials];
+    double sinDeltaSteps[maxPartials], cosDeltaSteps[maxPartials];
+
+    // The per-sample loop. It's a template so that a steady pitch doesn't
+    // pay for the extra rotation.
+    template <bool isGliding>
+    void renderPartials (float* output, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sum = 0.0f;
+
+            for (int k = 0; k < numPartials; ++k)
+            {
+                const float s = sinValues[k];
+                const float c = cosValues[k];
+                float sd = sinDeltas[k];
+                float cd = cosDeltas[k];
+
+                if (isGliding)
+                {
+                    const double sg = sinGlideDeltas[k];
+                    const double cg = cosGlideDeltas[k];
+
+                    sd = (float) sg;
+                    cd = (float) cg;
+                    sinGlideDeltas[k] = sg * cosDeltaSteps[k] + cg * sinDeltaSteps[k];
+                    cosGlideDeltas[k] = cg * cosDeltaSteps[k] - sg * sinDeltaSteps[k];
+                }
+
+                sum += s * amplitudes[k];
+                amplitudes[k] += amplitudeSteps[k];
+                sinValues[k] = s * cd + c * sd;
+                cosValues[k] = c * cd - s * sd;
+            }
+
+            output[i] = sum;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (AdditiveOscillatorBank)
+};
+
+
+#endif  // ADDITIVEOSCILLATORBANK_H_INCLUDED
@@ -16,95 +16,344 @@
 #ifndef AUDIOLIVESCROLLINGDISPLAY_H_INCLUDED
 #define AUDIOLIVESCROLLINGDISPLAY_H_INCLUDED
 
+#include <atomic>
+
+#include "../../Shared/AnimationScheduler.h"
+#include "../../Shared/FrameTimingMonitor.h"
+#include "../../Shared/AnalysisBus.h"
+
 
 //==============================================================================
 /* This component scrolls a continuous waveform showing the audio data that
-   is pushed into it via its pushAudioBuffer function.
+   gets published to an AnalysisBus.
+
+   Everything happens on the message thread: on each animation tick, the
+   display pulls whatever audio is new from the bus and reduces it to levels,
+   so the audio thread doesn't have to do any work for it at all.
+
+   By default the waveform is kept in an offscreen image which gets scrolled
+   along by however many new levels have arrived since the last paint, so only
+   those new columns need drawing. Call setScrollingImageEnabled (false) to
+   redraw the whole waveform every frame instead.
+
+   Like CachedTextLayer, the image is made at the display's physical resolution
+   and scaled back down when it's drawn, so it stays sharp on HiDPI screens.
+   Each level gets a whole number of physical pixels, so that scrolling the
+   image never has to move it by part of a pixel.
 */
 class LiveScrollingAudioDisplay  : public Component,
-                                   private Timer
+                                   private AnimationScheduler::Client
 {
 public:
-    LiveScrollingAudioDisplay (int refreshRateHz)
-        : nextSample (0), subSample (0), accumulator (0)
+    /** How each pixel's worth of input samples gets reduced to a single level. */
+    enum class EnvelopeMode
+    {
+        average,    // the mean magnitude (the original behaviour)
+        peak,       // the largest magnitude
+        rms         // the root-mean-square level
+    };
+
+    LiveScrollingAudioDisplay (AnalysisBus& source, int refreshRateHz)
+        : AnimationScheduler::Client (*this, 1000.0 / refreshRateHz), // this keeps repainting the component
+          reader (source), readBuffer (source.getNumChannels(), readBlockSize),
+          numLevelsWritten (0), numLevelsInImage (0), imageIsStale (true), useScrollingImage (true),
+          samplesInWindow (0), accumulator (0),
+          envelopeMode (EnvelopeMode::average), requestedEnvelopeMode (EnvelopeMode::average),
+          frameTiming ("LiveScrollingAudioDisplay", 1000.0 / refreshRateHz)
     {
         setOpaque (true);
         clear();
-
-        startTimerHz (refreshRateHz); // use a timer to keep repainting this component
     }
 
-    void pushAudioBuffer (float** channelData,
-                          int     numChannels,
-                          int     numSamples)
+    /** Can be called from any thread. The change takes effect at the start of the
+        next window of samples, so that no level ever mixes two different modes.
+    */
+    void setEnvelopeMode (EnvelopeMode newMode) noexcept
     {
-        for (int i = 0; i < numSamples; ++i)
-        {
-            float sample = 0;
-
-            for (int chan = 0; chan < numChannels; ++chan)
-                if (channelData[chan] != nullptr)
-                    sample += std::abs (channelData[chan][i]); // find the sum of all the channels
+        requestedEnvelopeMode.store (newMode, std::memory_order_relaxed);
+    }
 
-            pushSample (10.0f * sample); // boost the level to make it more easily visible.
-        }
+    /** Chooses between scrolling an offscreen image (the default) and
+        redrawing the whole waveform on every paint.
+    */
+    void setScrollingImageEnabled (bool shouldScrollImage)
+    {
+        useScrollingImage = shouldScrollImage;
+        waveformImage = Image();
+        repaint();
     }
 
     void clear()
     {
-        zeromem (samples, sizeof (samples));
+        for (auto& level : history)
+            level = 0.0f;
+
+        imageIsStale = true;
         accumulator = 0;
-        subSample = 0;
+        samplesInWindow = 0;
+        repaint();
     }
 
 private:
     //==========================================================================
-    float samples[1024];
-    int nextSample, subSample;
+    enum
+    {
+        inputSamplesPerPixel = 200,
+        maxPixels = 1024,
+        historySize = maxPixels,  // must be a power of two
+        historyMask = historySize - 1,
+        readBlockSize = 1024
+    };
+
+    AnalysisBus::Reader reader;
+    AudioBuffer<float> readBuffer;
+
+    float history[historySize];
+    uint32 numLevelsWritten;
+    float levelsToPaint[maxPixels];
+
+    Image waveformImage;
+    uint32 numLevelsInImage;
+    bool imageIsStale, useScrollingImage;
+
+    int samplesInWindow;
     float accumulator;
+    EnvelopeMode envelopeMode;                       // the one that the current window is using
+    std::atomic<EnvelopeMode> requestedEnvelopeMode;
+    FrameTimingMonitor frameTiming;
 
     void paint (Graphics& g) override
     {
-        g.fillAll (Colours::black);
+        const FrameTimingMonitor::ScopedPaint scopedPaint (frameTiming);
+
+        const int numPixels = jmin (getWidth(), (int) maxPixels);
+
+        if (! useScrollingImage)
+        {
+            g.fillAll (Colours::black);
+
+            uint32 firstLevel = numLevelsWritten - (uint32) historySize;
+            copyNewLevels (levelsToPaint, numPixels, firstLevel);
+            drawLevels (g, 0, numPixels);
+            return;
+        }
+
+        updateWaveformImage (numPixels, g.getInternalContext().getPhysicalPixelScaleFactor());
+
+        if (waveformImage.isValid())
+            g.drawImageTransformed (waveformImage, AffineTransform::scale (numPixels / (float) waveformImage.getWidth(),
+                                                                          getHeight() / (float) waveformImage.getHeight()));
+
+        if (getWidth() > numPixels)
+        {
+            g.setColour (Colours::black);
+            g.fillRect (numPixels, 0, getWidth() - numPixels, getHeight());
+        }
+    }
+
+    // Brings the offscreen image up to date, redrawing it completely only if it's
+    // the wrong size, has been cleared, or has fallen more than a whole width behind.
+    void updateWaveformImage (int numPixels, float scale)
+    {
+        const int columnWidth = jmax (1, roundToInt (scale));
+        const int imageWidth  = numPixels * columnWidth;
+        const int imageHeight = roundToInt (getHeight() * scale);
+
+        const bool needsFullRedraw = waveformImage.getWidth() != imageWidth
+                                      || waveformImage.getHeight() != imageHeight
+                                      || imageIsStale;
+
+        if (needsFullRedraw)
+        {
+            if (imageWidth <= 0 || imageHeight <= 0)
+            {
+                waveformImage = Image();
+                return;
+            }
+
+            if (waveformImage.getWidth() != imageWidth || waveformImage.getHeight() != imageHeight)
+                waveformImage = Image (Image::RGB, imageWidth, imageHeight, false);
+
+            imageIsStale = false;
+            numLevelsInImage = numLevelsWritten - (uint32) historySize;
+        }
+
+        const int numNew = copyNewLevels (levelsToPaint, numPixels, numLevelsInImage);
+
+        if (numNew == 0)
+            return;
+
+        // slide the old columns to the left, and draw the new ones into the gap
+        if (numNew < numPixels)
+            waveformImage.moveImageSection (0, 0, numNew * columnWidth, 0, (numPixels - numNew) * columnWidth, imageHeight);
+
+        // (the drawing's done in the component's coordinates, one unit per level)
+        Graphics ig (waveformImage);
+        ig.addTransform (AffineTransform::scale ((float) columnWidth, imageHeight / (float) getHeight()));
+        ig.setColour (Colours::black);
+        ig.fillRect (numPixels - numNew, 0, numNew, getHeight());
+
+        drawLevels (ig, numPixels - numNew, numNew);
+    }
 
+    // Draws the first num entries of levelsToPaint as columns, starting at x = startX.
+    void drawLevels (Graphics& g, int startX, int num) const
+    {
         const float midY = getHeight() * 0.5f;
-        int samplesAgo = (nextSample + numElementsInArray (samples) - 1);
 
         RectangleList<float> waveform;
-        waveform.ensureStorageAllocated ((int) numElementsInArray (samples));
+        waveform.ensureStorageAllocated (num);
 
-        for (int x = jmin (getWidth(), (int) numElementsInArray (samples)); --x >= 0;)
+        for (int i = num; --i >= 0;)
         {
-            const float sampleSize = midY * samples [samplesAgo-- % numElementsInArray (samples)];
-            waveform.addWithoutMerging (Rectangle<float> ((float) x, midY - sampleSize, 1.0f, sampleSize * 2.0f));
+            const float sampleSize = midY * levelsToPaint[i];
+            waveform.addWithoutMerging (Rectangle<float> ((float) (startX + i), midY - sampleSize, 1.0f, sampleSize * 2.0f));
         }
 
         g.setColour (Colours::lightgreen);
         g.fillRectList (waveform);
     }
 
-    void timerCallback() override
+    void animationTick() override
     {
+        frameTiming.timerTicked();
+
+        if (reader.checkAndResetCleared())
+            clear();
+
+        for (;;)
+        {
+            const int num = reader.read (readBuffer.getArrayOfWritePointers(), readBuffer.getNumChannels(), readBlockSize);
+
+            if (num == 0)
+                break;
+
+            processSamples (readBuffer.getArrayOfReadPointers(), readBuffer.getNumChannels(), num);
+        }
+
         repaint();
     }
 
-    void pushSample (const float newSample)
+    void processSamples (const float* const* channelData, int numChannels, int numSamples) noexcept
     {
-        accumulator += newSample;
+        const EnvelopeMode newMode = requestedEnvelopeMode.load (std::memory_order_relaxed);
 
-        if (subSample == 0)
+        if (newMode != envelopeMode)
         {
-            const int inputSamplesPerPixel = 200;
-
-            samples[nextSample] = accumulator / inputSamplesPerPixel;
-            nextSample = (nextSample + 1) % numElementsInArray (samples);
-            subSample = inputSamplesPerPixel;
+            // start a fresh window, rather than finishing this one with a different mode
+            envelopeMode = newMode;
             accumulator = 0;
+            samplesInWindow = 0;
+        }
+
+        // Rather than going sample by sample, each channel's data is reduced one
+        // whole window (or the part of it that's in this buffer) at a time.
+        for (int start = 0; start < numSamples;)
+        {
+            const int num = jmin (numSamples - start, inputSamplesPerPixel - samplesInWindow);
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                if (channelData[chan] != nullptr)
+                {
+                    const float* data = channelData[chan] + start;
+
+                    switch (envelopeMode)
+                    {
+                        case EnvelopeMode::peak:    accumulator = jmax (accumulator, getMaxMagnitude (data, num)); break;
+                        case EnvelopeMode::rms:     accumulator += getSumOfSquares (data, num); break;
+                        case EnvelopeMode::average:
+                        default:                    accumulator += getSumOfMagnitudes (data, num); break;
+                    }
+                }
+            }
+
+            samplesInWindow += num;
+            start += num;
+
+            if (samplesInWindow == inputSamplesPerPixel)
+                finishWindow();
         }
-        else
+    }
+
+    void finishWindow() noexcept
+    {
+        float level;
+
+        switch (envelopeMode)
         {
-            --subSample;
+            case EnvelopeMode::peak:    level = accumulator; break;
+            case EnvelopeMode::rms:     level = std::sqrt (accumulator / inputSamplesPerPixel); break;
+            case EnvelopeMode::average:
+            default:                    level = accumulator / inputSamplesPerPixel; break;
         }
+
+        history[numLevelsWritten & historyMask] = 10.0f * level; // boost the level to make it more easily visible.
+        ++numLevelsWritten;
+
+        samplesInWindow = 0;
+        accumulator = 0;
+    }
+
+    // Copies the levels written since firstLevel into dest, oldest first - or just
+    // the newest maxNum of them, if there are more than that. Then moves firstLevel
+    // on past the ones that were copied, and returns how many that was.
+    int copyNewLevels (float* dest, int maxNum, uint32& firstLevel) const noexcept
+    {
+        const int num = (int) jmin ((uint32) maxNum, numLevelsWritten - firstLevel);
+
+        for (int i = 0; i < num; ++i)
+            dest[i] = history[(numLevelsWritten - (uint32) (num - i)) & historyMask];
+
+        firstLevel = numLevelsWritten;
+        return num;
+    }
+
+    // These use four independent running totals, so that the compiler is free
+    // to turn each loop into SIMD code without breaking the order of the additions.
+    static float getSumOfMagnitudes (const float* data, int num) noexcept
+    {
+        float sums[4] = { 0 };
+        int i = 0;
+
+        for (; i + 4 <= num; i += 4)
+            for (int j = 0; j < 4; ++j)
+                sums[j] += std::abs (data[i + j]);
+
+        for (; i < num; ++i)
+            sums[0] += std::abs (data[i]);
+
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+
+    static float getSumOfSquares (const float* data, int num) noexcept
+    {
+        float sums[4] = { 0 };
+        int i = 0;
+
+        for (; i + 4 <= num; i += 4)
+            for (int j = 0; j < 4; ++j)
+                sums[j] += data[i + j] * data[i + j];
+
+        for (; i < num; ++i)
+            sums[0] += data[i] * data[i];
+
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+
+    static float getMaxMagnitude (const float* data, int num) noexcept
+    {
+        float maxes[4] = { 0 };
+        int i = 0;
+
+        for (; i + 4 <= num; i += 4)
+            for (int j = 0; j < 4; ++j)
+                maxes[j] = jmax (maxes[j], std::abs (data[i + j]));
+
+        for (; i < num; ++i)
+            maxes[0] = jmax (maxes[0], std::abs (data[i]));
+
+        return jmax (jmax (maxes[0], maxes[1]), jmax (maxes[2], maxes[3]));
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LiveScrollingAudioDisplay);
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef CACHEDTEXTLAYER_H_INCLUDED
+#define CACHEDTEXTLAYER_H_INCLUDED
+
+#include <functional>
+
+
+//==============================================================================
+/* Keeps a pre-rendered, transparent image of some text that never changes.
+
+   The text is laid out and rasterised by the paint function you give it the
+   first time draw() is called, and after that it's just composited as an
+   image. It only gets re-rendered when the area or the display scale changes,
+   or when you call invalidate().
+*/
+class CachedTextLayer
+{
+public:
+    typedef std::function<void (Graphics&, Rectangle<int>)> PaintFunction;
+
+    CachedTextLayer (PaintFunction paintFunctionToUse)
+        : paintFunction (paintFunctionToUse), cachedScale (0.0f)
+    {
+    }
+
+    void draw (Graphics& g, Rectangle<int> area)
+    {
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (cachedImage.isNull() || area.getWidth() != cachedArea.getWidth()
+             || area.getHeight() != cachedArea.getHeight() || scale != cachedScale)
+            render (area, scale);
+
+        cachedArea = area;
+
+        if (cachedImage.isValid())
+            g.drawImageTransformed (cachedImage, AffineTransform::scale (1.0f / cachedScale)
+                                                                 .translated ((float) area.getX(), (float) area.getY()));
+    }
+
+    void invalidate()
+    {
+        cachedImage = Image();
+    }
+
+private:
+    //==========================================================================
+    void render (Rectangle<int> area, float scale)
+    {
+        cachedScale = scale;
+
+        const int w = roundToInt (area.getWidth()  * scale);
+        const int h = roundToInt (area.getHeight() * scale);
+
+        if (w <= 0 || h <= 0)
+        {
+            cachedImage = Image();
+            return;
+        }
+
+        cachedImage = Image (Image::ARGB, w, h, true);
+
+        Graphics ig (cachedImage);
+        ig.addTransform (AffineTransform::scale (scale));
+        paintFunction (ig, area.withZeroOrigin());
+    }
+
+    //==========================================================================
+    PaintFunction paintFunction;
+    Image cachedImage;
+    Rectangle<int> cachedArea;
+    float cachedScale;
+
+    JUCE_DECLARE_NON_COPYABLE (CachedTextLayer)
+};
+
+
+#endif  // CACHEDTEXTLAYER_H_INCLUDED
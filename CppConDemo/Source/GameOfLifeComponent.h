@@ -19,6 +19,9 @@
 #include <array>
 #include <numeric>
 
+#include "../../Shared/AnimationScheduler.h"
+#include "../../Shared/FrameTimingMonitor.h"
+
 //==============================================================================
 enum class CellStatus
 {
@@ -97,23 +100,24 @@ private:
 
 //==============================================================================
 class GameOfLifeBoard : public Component,
-                        private Timer
+                        private AnimationScheduler::Client
 {
 public:
     //==========================================================================
     GameOfLifeBoard (int numberOfRows, int numberOfColumns)
-        : numRows (numberOfRows), numCols (numberOfColumns),
+        : AnimationScheduler::Client (*this, timestepInMilliseconds),
+          numRows (numberOfRows), numCols (numberOfColumns),
           thisBoard (numRows, numCols),
           nextBoard (numRows, numCols)
     {
         setSize (400, 400);
         generateBoardInitialConditions();
-
-        startTimer (timestepInMilliseconds);
     }
 
     void paint (Graphics& g) override
     {
+        const FrameTimingMonitor::ScopedPaint scopedPaint (frameTiming);
+
         float cellWidth  = (float) getWidth()  / (float) numCols;
         float cellHeight = (float) getHeight() / (float) numRows;
 
@@ -139,15 +143,15 @@ public:
 
     void restart()
     {
-        stopTimer();
         generateBoardInitialConditions();
-        startTimer (timestepInMilliseconds);
+        resumeAnimation();
     }
 
 private:
     //==========================================================================
-    void timerCallback() override
+    void animationTick() override
     {
+        frameTiming.timerTicked();
         advanceBoard();
         repaint();
     }
@@ -200,7 +204,9 @@ private:
     int numRows, numCols;
     GameOfLifeArray thisBoard, nextBoard;
 
-    const int timestepInMilliseconds = 500;
+    static const int timestepInMilliseconds = 500;
+
+    FrameTimingMonitor frameTiming { "GameOfLifeBoard", (double) timestepInMilliseconds };
 };
 
 //==============================================================================
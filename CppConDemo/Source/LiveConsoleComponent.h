@@ -13,8 +13,12 @@
   ==============================================================================
 */
 
+#include "LiveConsoleSink.h"
+#include "../../Shared/AnimationScheduler.h"
 
-class LiveConsoleComponent    : public Component
+
+class LiveConsoleComponent    : public Component,
+                                private AnimationScheduler::Client
 {
 public:
     /* 
@@ -62,10 +66,51 @@ public:
         return true;
     }
 
+    /*
+        Unlike print(), this can be called from any thread - even the audio
+        thread, as it never allocates or blocks. The messages are collected on
+        the message thread and appear in the log at the bottom of the console.
+    */
+    template <typename Type>
+    void log (const Type& value) noexcept
+    {
+        sink.post (value);
+    }
+
+    ~LiveConsoleComponent()
+    {
+        primeFinder.stopThread (2000);
+    }
+
 private:
+    /*
+        A worker thread that carries on where printYourStuffHere() stops: it
+        logs the primes up to 200 from its own thread, and then it's finished.
+        Try changing what it searches for!
+    */
+    struct PrimeFinderThread  : public Thread
+    {
+        PrimeFinderThread (LiveConsoleComponent& c)
+            : Thread ("Prime Finder"), console (c)
+        {
+        }
+
+        void run() override
+        {
+            for (int n = 50; n < 200 && ! threadShouldExit(); ++n)
+                if (isPrime (n))
+                    console.log ("worker thread found a prime: " + String (n));
+        }
+
+        LiveConsoleComponent& console;
+    };
+
     LiveConsoleComponent()
+        : AnimationScheduler::Client (*this, 1000.0 / 30.0),
+          primeFinder (*this)
     {
-        setSize (600, 600);
+        setSize (600, 750);
+        primeFinder.startThread();
     }
 
     void paint (Graphics& g) override
@@ -86,6 +131,45 @@ private:
             y += f.getHeight();
             g.drawSingleLineText (s, 8, y);
         }
+
+        // the log has its own pane along the bottom, with the newest lines at the end
+        const float logTop = getHeight() - (numLogLinesShown + 0.5f) * f.getHeight();
+
+        g.setColour (Colour (0xff202020));
+        g.fillRect (Rectangle<float> (0.0f, logTop, (float) getWidth(), getHeight() - logTop));
+        g.setColour (Colour (0xff73ff47));
+
+        y = logTop;
+
+        for (int i = jmax (0, loggedStrings.size() - numLogLinesShown); i < loggedStrings.size(); ++i)
+        {
+            y += f.getHeight();
+            g.drawSingleLineText (loggedStrings[i], 8, y);
+        }
+    }
+
+    void animationTick() override
+    {
+        bool anythingNew = false;
+        String message;
+
+        while (sink.pop (message))
+        {
+            loggedStrings.add (message);
+            anythingNew = true;
+        }
+
+        if (const int numDropped = sink.getAndResetNumDropped())
+        {
+            loggedStrings.add ("(" + String (numDropped) + " messages dropped)");
+            anythingNew = true;
+        }
+
+        if (anythingNew)
+        {
+            loggedStrings.removeRange (0, loggedStrings.size() - maxLoggedStrings);
+            repaint();
+        }
     }
 
     void newline()
@@ -100,6 +184,11 @@ private:
     }
 
 private:
-    StringArray strings;
+    StringArray strings, loggedStrings;
+    LiveConsoleSink sink;
+    PrimeFinderThread primeFinder;
+
+    const int maxLoggedStrings = 200;
+    const int numLogLinesShown = 10;
 };
 
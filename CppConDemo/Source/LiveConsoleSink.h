@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef LIVECONSOLESINK_H_INCLUDED
+#define LIVECONSOLESINK_H_INCLUDED
+
+#include <atomic>
+#include <type_traits>
+
+
+//==============================================================================
+/* A fixed-size, lock-free queue of console messages.
+
+   Any number of threads (including the audio thread) can call post() at the
+   same time: it never allocates, never blocks and never waits for the reader.
+   The message is stored as a raw value in a preallocated slot, and is only
+   turned into a String later on, when the single consumer calls pop().
+
+   If the queue is full, the message is dropped and counted instead of
+   blocking the caller.
+*/
+class LiveConsoleSink
+{
+public:
+    LiveConsoleSink()
+        : writePosition (0), readPosition (0), numDropped (0)
+    {
+        for (uint32 i = 0; i < (uint32) numSlots; ++i)
+            slots[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    //==========================================================================
+    /** Queues a value to be printed. Safe to call from any thread.
+        Returns false if the queue was full and the message had to be dropped.
+    */
+    template <typename Type>
+    bool post (const Type& value) noexcept
+    {
+        uint32 position;
+
+        if (Slot* slot = claimSlot (position))
+        {
+            store (*slot, value);
+            slot->sequence.store (position + 1, std::memory_order_release);
+            return true;
+        }
+
+        numDropped.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Formats and removes the oldest published message.
+        This must only ever be called from one thread at a time (normally the
+        message thread). Returns false if there was nothing to read.
+    */
+    bool pop (String& result)
+    {
+        Slot& slot = slots[readPosition & slotMask];
+
+        if ((int32) (slot.sequence.load (std::memory_order_acquire) - (readPosition + 1)) < 0)
+            return false;
+
+        result = format (slot);
+        slot.sequence.store (readPosition + (uint32) numSlots, std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+    /** Returns the number of messages dropped since the last call, and resets it. */
+    int getAndResetNumDropped() noexcept
+    {
+        return numDropped.exchange (0, std::memory_order_relaxed);
+    }
+
+private:
+    //==========================================================================
+    enum class ValueType
+    {
+        text,
+        signedInteger,
+        unsignedInteger,
+        floatingPoint
+    };
+
+    enum
+    {
+        numSlots = 1024,   // must be a power of two
+        slotMask = numSlots - 1,
+        maxTextLength = 120
+    };
+
+    struct Slot
+    {
+        std::atomic<uint32> sequence;
+        ValueType type;
+
+        union
+        {
+            int64 signedValue;
+            uint64 unsignedValue;
+            double floatValue;
+        };
+
+        char text[maxTextLength + 1];
+    };
+
+    //==========================================================================
+    Slot* claimSlot (uint32& position) noexcept
+    {
+        position = writePosition.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = slots[position & slotMask];
+            const int32 diff = (int32) (slot.sequence.load (std::memory_order_acquire) - position);
+
+            if (diff == 0)
+            {
+                if (writePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                    return &slot;
+            }
+            else if (diff < 0)
+            {
+                return nullptr; // the reader hasn't caught up yet, so the queue is full
+            }
+            else
+            {
+                position = writePosition.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <typename Type>
+    static typename std::enable_if<std::is_integral<Type>::value && std::is_signed<Type>::value>::type
+    store (Slot& slot, Type value) noexcept
+    {
+        slot.type = ValueType::signedInteger;
+        slot.signedValue = (int64) value;
+    }
+
+    template <typename Type>
+    static typename std::enable_if<std::is_integral<Type>::value && ! std::is_signed<Type>::value>::type
+    store (Slot& slot, Type value) noexcept
+    {
+        slot.type = ValueType::unsignedInteger;
+        slot.unsignedValue = (uint64) value;
+    }
+
+    template <typename Type>
+    static typename std::enable_if<std::is_floating_point<Type>::value>::type
+    store (Slot& slot, Type value) noexcept
+    {
+        slot.type = ValueType::floatingPoint;
+        slot.floatValue = (double) value;
+    }
+
+    static void store (Slot& slot, const char* value) noexcept
+    {
+        slot.type = ValueType::text;
+        int i = 0;
+
+        if (value != nullptr)
+            for (; i < maxTextLength && value[i] != 0; ++i)
+                slot.text[i] = value[i];
+
+        slot.text[i] = 0;
+    }
+
+    // copying the characters out of an existing String doesn't allocate anything
+    static void store (Slot& slot, const String& value) noexcept
+    {
+        slot.type = ValueType::text;
+        value.copyToUTF8 (slot.text, (size_t) maxTextLength + 1);
+    }
+
+    static String format (const Slot& slot)
+    {
+        switch (slot.type)
+        {
+            case ValueType::signedInteger:    return String (slot.signedValue);
+            case ValueType::unsignedInteger:  return String (slot.unsignedValue);
+            case ValueType::floatingPoint:    return String (slot.floatValue);
+            case ValueType::text:
+            default:                          return String::fromUTF8 (slot.text);
+        }
+    }
+
+    //==========================================================================
+    Slot slots[numSlots];
+    std::atomic<uint32> writePosition;
+    uint32 readPosition;
+    std::atomic<int> numDropped;
+
+    JUCE_DECLARE_NON_COPYABLE (LiveConsoleSink)
+};
+
+
+#endif  // LIVECONSOLESINK_H_INCLUDED
@@ -19,6 +19,8 @@
 #include "SoundComponent.h"
 #include "GameOfLifeComponent.h"
 #include "LiveConsoleComponent.h"
+#include "../../Shared/AnimationScheduler.h"
+#include "../../Shared/FrameTimingMonitor.h"
 
 /*
    This file contains the startup code that is used when you compile and launch
@@ -42,7 +44,16 @@ public:
     //==============================================================================
     void initialise (const String& commandLine) override
     {
-        mainWindow = new MainWindow (getApplicationName());
+        // launch with --opengl to render the demo pages on an OpenGL thread. On Linux the
+        // GL context still needs an X display, so on a headless box run it under Xvfb, with
+        // LIBGL_ALWAYS_SOFTWARE=1 to make Mesa use its llvmpipe renderer - see the README
+        const bool useOpenGL = commandLine.contains ("--opengl");
+
+        // launch with --frame-stats to show the paint/timer stats of the animated
+        // components, and to log them as JSON when the app quits
+        const bool showFrameStats = commandLine.contains ("--frame-stats");
+
+        mainWindow = new MainWindow (getApplicationName(), useOpenGL, showFrameStats);
     }
 
     void shutdown() override
@@ -61,9 +72,9 @@ public:
     class MainWindow    : public DocumentWindow
     {
     public:
-        MainWindow (String name)  : DocumentWindow (name,
-                                                    Colours::lightgrey,
-                                                    DocumentWindow::allButtons)
+        MainWindow (String name, bool useOpenGL, bool showFrameStats)
+            : DocumentWindow (name, Colours::lightgrey, DocumentWindow::allButtons),
+              frameStatsEnabled (showFrameStats)
         {
             setUsingNativeTitleBar (true);
 
@@ -75,16 +86,47 @@ public:
             //Component* content = new GameOfLifeComponent();
 
             setContentOwned (content, true);
+
+            if (useOpenGL)
+                openGLContext.attachTo (*content);
+
+            if (frameStatsEnabled)
+            {
+                frameStatsOverlay.setAlwaysOnTop (true);
+                content->addAndMakeVisible (frameStatsOverlay);
+            }
+
             centreWithSize (getWidth(), getHeight());
             setVisible (true);
         }
 
+        ~MainWindow()
+        {
+            if (frameStatsEnabled)
+                Logger::writeToLog (FrameTimingMonitor::createJSONDump());
+
+            // the context must be detached before the content component gets deleted
+            openGLContext.detach();
+        }
+
+        void resized() override
+        {
+            DocumentWindow::resized();
+
+            if (Component* content = getContentComponent())
+                frameStatsOverlay.setBounds (content->getLocalBounds());
+        }
+
         void closeButtonPressed() override
         {
             JUCEApplication::getInstance()->systemRequestedQuit();
         }
 
     private:
+        OpenGLContext openGLContext;
+        FrameTimingOverlay frameStatsOverlay;
+        const bool frameStatsEnabled;
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
     };
 
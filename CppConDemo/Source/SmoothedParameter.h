@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demo created for CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef SMOOTHEDPARAMETER_H_INCLUDED
+#define SMOOTHEDPARAMETER_H_INCLUDED
+
+#include "../../Shared/ParameterStore.h"
+
+
+//==============================================================================
+/* Follows an AtomicParameter (which can be set from any thread) on the audio
+   thread, gliding towards its value with a linear ramp instead of jumping,
+   to avoid zipper noise.
+
+   The audio thread asks for the value at the end of each block with
+   getNextValue(), and can use getCurrentValue() beforehand to get the value
+   at the start of the block, so that it can interpolate between the two.
+*/
+class SmoothedParameter
+{
+public:
+    SmoothedParameter (AtomicParameter& parameterToFollow, double rampLengthInSeconds)
+        : target (parameterToFollow),
+          currentValue (target.get()), lastTarget (currentValue), step (0),
+          rampLengthSeconds (rampLengthInSeconds), rampLengthSamples (0), samplesLeft (0)
+    {
+    }
+
+    double getTargetValue() const noexcept
+    {
+        return target.get();
+    }
+
+    //==========================================================================
+    /** Call this from the audio thread before rendering starts.
+        It jumps straight to the current target.
+    */
+    void reset (double sampleRate) noexcept
+    {
+        rampLengthSamples = jmax (1, roundToInt (rampLengthSeconds * sampleRate));
+        currentValue = lastTarget = getTargetValue();
+        samplesLeft = 0;
+    }
+
+    /** Returns the value at the start of the next block. */
+    double getCurrentValue() const noexcept     { return currentValue; }
+
+    /** Moves the ramp on by a block of numSamples, and returns the value at the end of it. */
+    double getNextValue (int numSamples) noexcept
+    {
+        const double newTarget = getTargetValue();
+
+        if (newTarget != lastTarget)
+        {
+            lastTarget = newTarget;
+            samplesLeft = rampLengthSamples;
+            step = (newTarget - currentValue) / rampLengthSamples;
+        }
+
+        if (samplesLeft > 0)
+        {
+            const int numToRamp = jmin (numSamples, samplesLeft);
+            samplesLeft -= numToRamp;
+            currentValue = (samplesLeft == 0) ? lastTarget : currentValue + step * numToRamp;
+        }
+
+        return currentValue;
+    }
+
+    //==========================================================================
+    /** Multiplies source by a gain that moves linearly from startGain to endGain
+        over the block, and writes the result to dest (which may be the same as source).
+    */
+    static void applyGainRamp (float* dest, const float* source, int numSamples,
+                               float startGain, float endGain) noexcept
+    {
+        if (startGain == endGain)
+        {
+            FloatVectorOperations::copyWithMultiply (dest, source, startGain, numSamples);
+            return;
+        }
+
+        const float gainStep = (endGain - startGain) / numSamples;
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = source[i] * (startGain + gainStep * i);
+    }
+
+private:
+    //==========================================================================
+    AtomicParameter& target;
+    double currentValue, lastTarget, step;
+    double rampLengthSeconds;
+    int rampLengthSamples, samplesLeft;
+
+    JUCE_DECLARE_NON_COPYABLE (SmoothedParameter)
+};
+
+
+#endif  // SMOOTHEDPARAMETER_H_INCLUDED
@@ -17,26 +17,40 @@
 #define SOUNDCOMPONENT_H_INCLUDED
 
 #include "AudioLiveScrollingDisplay.h"
+#include "CachedTextLayer.h"
+#include "AdditiveOscillatorBank.h"
+#include "SmoothedParameter.h"
 
 
 //==============================================================================
 class SoundComponent   : public Component,
-                         public AudioIODeviceCallback
+                         public AudioIODeviceCallback,
+                         private Slider::Listener
 {
 public:
     SoundComponent()
-      : liveAudioDisplayComp (75),
+      : analysisBus (2, 16384),
+        liveAudioDisplayComp (analysisBus, 75),
         sampleRate (0.0),
-        frequency (440.0),  // <-- this determines the pitch of the sound!
+        frequency (parameters.add ("frequency", 20.0f, 5000.0f, 440.0f), 0.05),  // <-- this determines the pitch of the sound!
+        level (parameters.add ("level", 0.0f, 0.5f, 0.05f), 0.02),   // <-- this determines the overall volume!
         phase (0.0),
-        phaseDelta (0.0),
-        level (0.05)   // <-- this determines the overall volume!
+        time (0.0f)
     {
         // this connects the component to the default audio output of the computer
         deviceManager.initialiseWithDefaultDevices (0, 2);
         deviceManager.addAudioCallback (this);
 
+        AtomicParameter& frequencyParameter = *parameters.get ("frequency");
+        frequencySlider.setRange (frequencyParameter.getMinimum(), frequencyParameter.getMaximum());
+        frequencySlider.setSkewFactorFromMidPoint (440.0);
+        frequencySlider.setTextValueSuffix (" Hz");
+        frequencySlider.setValue (frequencyParameter.get(), dontSendNotification);
+        frequencySlider.addListener (this);
+        frequencyLabel.attachToComponent (&frequencySlider, true);
+
         addAndMakeVisible (liveAudioDisplayComp);
+        addAndMakeVisible (frequencySlider);
         addAndMakeVisible (forumLinkButton);
 
         forumLinkButton.setColour (HyperlinkButton::textColourId, Colours::white);
@@ -49,18 +63,28 @@ public:
         deviceManager.removeAudioCallback (this);
     }
 
+    // These can be called from any thread, and the sound will glide smoothly to the new values.
+    void setFrequency (double newFrequencyHz)    { parameters.get ("frequency")->set ((float) newFrequencyHz); }
+    void setLevel (double newLevel)              { parameters.get ("level")->set ((float) newLevel); }
+
+    ParameterStore& getParameters() noexcept     { return parameters; }
+
     void paint (Graphics& g) override
     {
         g.fillAll (Colour (0xff274630));
+        textLayer.draw (g, getLocalBounds());
+    }
 
+    void paintText (Graphics& g, Rectangle<int> area)
+    {
         g.setFont (Font ("Arial", 20, Font::italic));
         g.setColour (Colours::yellow);
         g.drawText ("Modify the C++ code that generates the sound -- while it is playing!",
-                    getLocalBounds(), Justification::centred);
+                    area, Justification::centred);
 
         g.setFont (Font ("Arial", 16, Font::italic));
         g.drawText ("-- have a look at SoundComponent::audioDeviceIOCallback()",
-                    Rectangle<int> {0, 0, getWidth(), getHeight() + 60},
+                    Rectangle<int> {0, 0, area.getWidth(), area.getHeight() + 60},
                     Justification::centred);
     }
 
@@ -69,6 +93,14 @@ public:
         Rectangle<int> r (getLocalBounds().reduced (8));
         liveAudioDisplayComp.setBounds (r.removeFromTop (64));
         forumLinkButton.setBounds (r.removeFromBottom (24));
+        frequencySlider.setBounds (r.removeFromBottom (24).withTrimmedLeft (80));
+    }
+
+    // (the sound glides to the new pitch rather than jumping)
+    void sliderValueChanged (Slider* slider) override
+    {
+        if (slider == &frequencySlider)
+            setFrequency (frequencySlider.getValue());
     }
 
     void audioDeviceIOCallback (const float** /*inputChannelData*/,
@@ -83,57 +115,89 @@ public:
         // --> feel free to play around with the numbers and formulae here
         //     and notice how the sound changes as you tweak the code!
 
+        // The modulation runs at control rate: everything below is worked out for the
+        // start and the end of the block, and ramped linearly in between.
+        // Time moves on by the real duration of the block, so the sound doesn't depend
+        // on the buffer size.
+        const float endTime = time + (float) (numSamples * modulationSpeed / sampleRate);
+
         float tune = std::floor (2.5f + 1.5f * sin (time * 0.5f));
 
-        for (int sample = 0; sample < numSamples; ++sample)
+        oscillators.clearPartials();
+        oscillators.addPartial (1.0, 1.0f);
+        oscillators.addPartial (1.20, cos (time * 0.5f), cos (endTime * 0.5f));
+
+        for (float i = 0.0f; i < (4.0f + 4.0f * std::sin (time * 2.0f));)
         {
-            float currentSample = (float) std::sin (phase);
-            currentSample += (float) std::sin (phase * 1.20f) * cos (time * 0.5f);
-
-            for (float i = 0.0f; i < (4.0f + 4.0f * std::sin (time * 2.0f));)
-            {
-                currentSample += (float) std::sin (phase * i);
-                i += jmax (tune, 0.1f);
-            }
-
-            phase += phaseDelta;
-            outputChannelData[0][sample] = currentSample * level * (0.5f + 0.5 * std::sin (time));
-            outputChannelData[1][sample] = currentSample * level * (0.5f + 0.5 * std::cos (time));
+            oscillators.addPartial (i, 1.0f);
+            i += jmax (tune, 0.1f);
         }
 
-        time += 0.02f;
+        // the pitch glides sample by sample, from the start of the block to the end
+        const double startPhaseDelta = getPhaseDelta (frequency.getCurrentValue());
+        const double endPhaseDelta   = getPhaseDelta (frequency.getNextValue (numSamples));
+        oscillators.render (outputChannelData[0], numSamples, phase, startPhaseDelta, endPhaseDelta);
+
+        const double startLevel = level.getCurrentValue();
+        const double endLevel   = level.getNextValue (numSamples);
+
+        if (numOutputChannels > 1)
+            SmoothedParameter::applyGainRamp (outputChannelData[1], outputChannelData[0], numSamples,
+                                              (float) (startLevel * (0.5f + 0.5 * std::cos (time))),
+                                              (float) (endLevel   * (0.5f + 0.5 * std::cos (endTime))));
+
+        SmoothedParameter::applyGainRamp (outputChannelData[0], outputChannelData[0], numSamples,
+                                          (float) (startLevel * (0.5f + 0.5 * std::sin (time))),
+                                          (float) (endLevel   * (0.5f + 0.5 * std::sin (endTime))));
 
-        // update the visual scrolling audio display:
-        liveAudioDisplayComp.pushAudioBuffer (outputChannelData, numOutputChannels, numSamples);
+        time = endTime;
+
+        // hand the audio over to the visual scrolling audio display:
+        analysisBus.publish (outputChannelData, numOutputChannels, numSamples);
     }
 
     void audioDeviceAboutToStart (AudioIODevice* device) override
     {
         sampleRate = device->getCurrentSampleRate();
-        updatePhaseDelta();
-        liveAudioDisplayComp.clear();
+        frequency.reset (sampleRate);
+        level.reset (sampleRate);
+        analysisBus.clear();
     }
 
     virtual void audioDeviceStopped() override
     {
-        liveAudioDisplayComp.clear();
+        analysisBus.clear();
     }
 
 
 private:
     //==========================================================================
-    void updatePhaseDelta()
+    double getPhaseDelta (double frequencyHz) const noexcept
     {
-        const double cyclesPerSample = frequency / sampleRate;
-        phaseDelta = cyclesPerSample * 2.0 * double_Pi;
+        const double cyclesPerSample = frequencyHz / sampleRate;
+        return cyclesPerSample * 2.0 * double_Pi;
     }
 
     AudioDeviceManager deviceManager;
+    AnalysisBus analysisBus;
     LiveScrollingAudioDisplay liveAudioDisplayComp;
+    AdditiveOscillatorBank oscillators;
 
-    double sampleRate, frequency, phase, phaseDelta, level;
+    double sampleRate;
+    ParameterStore parameters;
+    SmoothedParameter frequency, level;
+    double phase;
     float time;
 
+    // how fast the modulation moves, in units of "time" per second
+    // (this matches the original speed of 0.02 per block of 512 samples at 44.1kHz)
+    const double modulationSpeed = 0.02 * 44100.0 / 512.0;
+
+    Slider frequencySlider { Slider::LinearHorizontal, Slider::TextBoxRight };
+    Label frequencyLabel { String(), "Frequency" };
+
+    CachedTextLayer textLayer { [this] (Graphics& g, Rectangle<int> area) { paintText (g, area); } };
+
     HyperlinkButton forumLinkButton { "If you want to discuss the Projucer with us, click here to visit the JUCE forum!",
                                       URL ("http://www.juce.com/forum") };
 
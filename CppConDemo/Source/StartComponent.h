@@ -16,22 +16,38 @@
 #ifndef STARTCOMPONENT_H_INCLUDED
 #define STARTCOMPONENT_H_INCLUDED
 
+#include "CachedTextLayer.h"
+#include "../../Shared/AnimationScheduler.h"
+#include "../../Shared/FrameTimingMonitor.h"
+
 
 //==============================================================================
 class ProjucerDemoStartComponent : public Component,
-                                   private Timer
+                                   private AnimationScheduler::Client
 {
 public:
     ProjucerDemoStartComponent()
+        : AnimationScheduler::Client (*this, 1000.0 / 60.0)
     {
         setSize (600, 600);
-        startTimerHz (60);
     }
 
     void paint (Graphics& g) override
     {
+        const FrameTimingMonitor::ScopedPaint scopedPaint (frameTiming);
+
         g.fillAll (Colour (0xff333333));  // <-- change the background colour here!
 
+        // the text never changes, so it's only rendered once and then re-used
+        textLayer.draw (g, getLocalBounds());
+
+        g.setColour (Colours::white.withAlpha (0.5f)); // <-- change the opacity of the spiral here!
+
+        paintSpiral (g);
+    }
+
+    void paintText (Graphics& g, Rectangle<int> area)
+    {
         g.setColour (Colour (0xff88e13a));
         g.setFont (Font ("Arial", 20.0f, Font::italic));   // <-- change the font here!
 
@@ -40,11 +56,7 @@ public:
                              20, 30, 380);  // <-- change the text position here!
 
         g.setColour (Colour (0xff333333));
-        g.drawText ("TADA!", getLocalBounds(), Justification::centred);
-
-        g.setColour (Colours::white.withAlpha (0.5f)); // <-- change the opacity of the spiral here!
-
-        paintSpiral (g);
+        g.drawText ("TADA!", area, Justification::centred);
     }
 
     void paintSpiral (Graphics& g)
@@ -52,35 +64,79 @@ public:
         int numCircles = 9; // <-- try editing some variables or logic!
         int tailLength = 15;
 
-        float theta = 2.0f * M_PI / (float) jmax (numCircles, 1);
+        float frequencyX    = 0.1f;
+        float frequencyY    = 0.2f;
+
+        frequencyY = frequencyX;      // <-- comment out this line to desync X and Y
 
-        for (float i = 0.0f; i < 2.0f * M_PI; i += theta)
+        numCircles = jmax (numCircles, 1);
+        tailLength = jmax (tailLength, 0);
+        updateCircleAngles (numCircles);
+
+        // All the dots are collected into a single path, so that the whole
+        // spiral gets rasterised with one fill instead of one per dot.
+        spiral.clear();
+        spiral.preallocateSpace (numCircles * tailLength * 32);
+
+        const float centreX = getWidth() * 0.5f;
+        const float centreY = getHeight() * 0.5f;
+
+        for (int j = 0; j < tailLength; ++j)
         {
-            for (int j = 0; j < tailLength; ++j)
+            float radius        = tailLength + 2.0f - j;
+            float mainRadius    = 80.0f + j * 5.0f;    // <-- drag these numbers with the slider!
+
+            // The angle of each dot is (circle angle + wobble). The wobble only depends
+            // on j, so rather than calling sin() for every dot, we can expand
+            // sin (a + b) and cos (a + b) with the sin/cos tables of the circle angles.
+            const float wobbleX = std::sin (time - j * frequencyX);
+            const float wobbleY = std::sin (time - j * frequencyY);
+            const float sinWobbleX = mainRadius * std::sin (wobbleX), cosWobbleX = mainRadius * std::cos (wobbleX);
+            const float sinWobbleY = mainRadius * std::sin (wobbleY), cosWobbleY = mainRadius * std::cos (wobbleY);
+
+            for (int i = 0; i < numCircles; ++i)
             {
-                float radius        = jmax (tailLength, 0) + 2.0f - j;
-                float mainRadius    = 80.0f + j * 5.0f;    // <-- drag these numbers with the slider!
-                float frequencyX    = 0.1f;
-                float frequencyY    = 0.2f;
-
-                frequencyY = frequencyX;      // <-- comment out this line to desync X and Y
+                const float x = centreX + sinCircleAngles[i] * cosWobbleX + cosCircleAngles[i] * sinWobbleX;
+                const float y = centreY + cosCircleAngles[i] * cosWobbleY - sinCircleAngles[i] * sinWobbleY;
 
-                g.fillEllipse (getWidth() * 0.5f +  mainRadius * std::sin (i + std::sin (time - j*frequencyX)) - radius * 0.5f,
-                               getHeight() * 0.5f + mainRadius * std::cos (i + std::sin (time - j*frequencyY)) - radius * 0.5f,
-                               radius,
-                               radius);   // <-- play around with this formula!
+                spiral.addEllipse (x - radius * 0.5f, y - radius * 0.5f, radius, radius);   // <-- play around with this formula!
             }
         }
+
+        g.fillPath (spiral);
+    }
+
+    void updateCircleAngles (int numCircles)
+    {
+        if (sinCircleAngles.size() == numCircles)
+            return;
+
+        sinCircleAngles.clearQuick();
+        cosCircleAngles.clearQuick();
+
+        const float theta = 2.0f * float_Pi / (float) numCircles;
+
+        for (int i = 0; i < numCircles; ++i)
+        {
+            sinCircleAngles.add (std::sin (i * theta));
+            cosCircleAngles.add (std::cos (i * theta));
+        }
     }
 
-    void timerCallback() override
+    void animationTick() override
     {
+        frameTiming.timerTicked();
         time += 0.01f;   // <-- you can change the speed here!
         repaint();
     }
 
     float time = 0.0f;
 
+    Path spiral;
+    FrameTimingMonitor frameTiming { "ProjucerDemoStartComponent", 1000.0 / 60.0 };
+    CachedTextLayer textLayer { [this] (Graphics& g, Rectangle<int> area) { paintText (g, area); } };
+    Array<float> sinCircleAngles, cosCircleAngles;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProjucerDemoStartComponent)
 };
 
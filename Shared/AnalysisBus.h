@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demos created for
+   the JUCE Summit 2015 and CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef ANALYSISBUS_H_INCLUDED
+#define ANALYSISBUS_H_INCLUDED
+
+// Note: the AudioDemo includes this file from inside a struct, so everything
+// in here has to be a class - no free functions or static data members!
+// (it also means <atomic>, <limits> and <vector> have to be included before that struct)
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/* Carries the audio that's being played over to any number of visualisers.
+
+   The audio thread calls publish() once per block, and that's all it ever
+   does - it doesn't know or care how many readers there are, and never waits
+   for any of them. Each GUI component that wants the audio has its own
+   AnalysisBus::Reader, and pulls whatever is new whenever it likes.
+
+   The samples go into a ring buffer. The writer announces how far it's about
+   to write before it starts, and how far it got once it's done; a reader
+   copies what it wants and then checks that the writer hasn't started on
+   that part of the ring in the meantime, trying again if it has. A reader
+   that falls too far behind just skips the samples it missed.
+
+   When there's nothing playing, the writer can call publishSilence() instead,
+   which stops touching the ring at all once it's full of zeros, and the
+   readers can ask how long it's been silent for and skip their own work.
+*/
+class AnalysisBus
+{
+public:
+    /** The capacity gets rounded up to a power of two. */
+    AnalysisBus (int numChannelsToStore, int capacityInSamples)
+        : numChannels (numChannelsToStore),
+          capacity ((int) nextPowerOfTwo (capacityInSamples)),
+          mask ((uint32) capacity - 1),
+          ring ((size_t) (numChannelsToStore * capacity)),
+          numSamplesStarted (0), numSamplesWritten (0), numClears (0), numSilentSamples (0)
+    {
+        jassert (numChannels > 0);
+    }
+
+    int getNumChannels() const noexcept     { return numChannels; }
+    int getCapacity() const noexcept        { return capacity; }
+
+    //==========================================================================
+    /** Writer side: adds a block of audio. Only call this from one thread at a time.
+        Channels beyond the bus's number of channels are ignored, and null or
+        missing channels are stored as silence.
+    */
+    void publish (const float* const* channelData, int numChannelsIn, int numSamples) noexcept
+    {
+        writeBlock (channelData, numChannelsIn, numSamples);
+        numSilentSamples.store (0, std::memory_order_release);
+    }
+
+    /** Writer side: the same as publishing a block of zeros, except that once the
+        whole ring is silent, it only has to move the position on.
+    */
+    void publishSilence (int numSamples) noexcept
+    {
+        const int silentSoFar = numSilentSamples.load (std::memory_order_relaxed);
+
+        if (silentSoFar < capacity)
+        {
+            writeBlock (nullptr, 0, numSamples);
+        }
+        else
+        {
+            const uint32 end = numSamplesWritten.load (std::memory_order_relaxed) + (uint32) numSamples;
+            numSamplesStarted.store (end, std::memory_order_relaxed);
+            numSamplesWritten.store (end, std::memory_order_release);
+        }
+
+        // (this saturates rather than wrapping round after a day or so of silence)
+        numSilentSamples.store (jmin (silentSoFar, std::numeric_limits<int>::max() - numSamples) + numSamples,
+                                std::memory_order_release);
+    }
+
+    /** Writer side: tells the readers that the audio has stopped or restarted, so
+        whatever they're showing is out of date.
+    */
+    void clear() noexcept
+    {
+        numClears.fetch_add (1, std::memory_order_release);
+    }
+
+    /** Returns how many of the most recently published samples were known to be
+        silent, i.e. came from publishSilence(). A visualiser that's showing at
+        least this many samples can skip fetching them, as they're all zeros.
+    */
+    int getNumSilentSamples() const noexcept
+    {
+        return numSilentSamples.load (std::memory_order_acquire);
+    }
+
+    //==========================================================================
+    /** Copies the most recent numSamples of one channel into dest, oldest first.
+        This doesn't affect any Readers, so it can be used to just grab a snapshot.
+        numSamples must be no more than half the capacity.
+    */
+    void copyLatest (float* dest, int numSamples, int channel = 0) const noexcept
+    {
+        jassert (numSamples <= capacity / 2);
+
+        for (;;)
+        {
+            const uint32 end = numSamplesWritten.load (std::memory_order_acquire);
+            const uint32 start = end - (uint32) numSamples;
+
+            copyRange (dest, channel, start, numSamples);
+
+            if (isStillValid (start))
+                return;
+        }
+    }
+
+    //==========================================================================
+    /* Pulls the audio from an AnalysisBus as a continuous stream. Each reader
+       keeps its own position, so they don't affect each other at all.
+    */
+    class Reader
+    {
+    public:
+        /** The reader starts at the bus's current position. */
+        Reader (const AnalysisBus& busToReadFrom) noexcept
+            : bus (busToReadFrom),
+              position (bus.numSamplesWritten.load (std::memory_order_acquire)),
+              numClearsSeen (bus.numClears.load (std::memory_order_acquire)),
+              numSkipped (0)
+        {
+        }
+
+        /** Copies up to maxSamples of the audio published since the last call into
+            destChannels, and returns how many samples that was. If the reader has
+            fallen more than half the bus's capacity behind, the oldest samples are
+            skipped (see getAndResetNumSkipped()).
+        */
+        int read (float* const* destChannels, int numDestChannels, int maxSamples) noexcept
+        {
+            const uint32 maxBehind = (uint32) bus.capacity / 2;
+
+            for (;;)
+            {
+                const uint32 end = bus.numSamplesWritten.load (std::memory_order_acquire);
+                uint32 start = position;
+
+                if (end - start > maxBehind)
+                    start = end - maxBehind;
+
+                const int num = (int) jmin ((uint32) jmax (0, maxSamples), end - start);
+
+                for (int chan = 0; chan < numDestChannels; ++chan)
+                {
+                    if (chan < bus.numChannels)
+                        bus.copyRange (destChannels[chan], chan, start, num);
+                    else
+                        FloatVectorOperations::clear (destChannels[chan], num);
+                }
+
+                if (bus.isStillValid (start))
+                {
+                    numSkipped += (int) (start - position);
+                    position = start + (uint32) num;
+                    return num;
+                }
+            }
+        }
+
+        /** Jumps straight to the latest sample, without counting the ones in between
+            as skipped - e.g. for a reader that has decided not to look at some silence.
+        */
+        void skipToEnd() noexcept
+        {
+            position = bus.numSamplesWritten.load (std::memory_order_acquire);
+        }
+
+        /** Returns true (once) if the writer has called clear() since the last check. */
+        bool checkAndResetCleared() noexcept
+        {
+            const uint32 clears = bus.numClears.load (std::memory_order_acquire);
+
+            if (clears == numClearsSeen)
+                return false;
+
+            numClearsSeen = clears;
+            return true;
+        }
+
+        /** Returns the number of samples this reader missed because it fell behind. */
+        int getAndResetNumSkipped() noexcept
+        {
+            const int n = numSkipped;
+            numSkipped = 0;
+            return n;
+        }
+
+        int getNumChannels() const noexcept         { return bus.numChannels; }
+        int getNumSilentSamples() const noexcept    { return bus.getNumSilentSamples(); }
+
+    private:
+        const AnalysisBus& bus;
+        uint32 position, numClearsSeen;
+        int numSkipped;
+
+        JUCE_DECLARE_NON_COPYABLE (Reader)
+    };
+
+private:
+    //==========================================================================
+    const int numChannels, capacity;
+    const uint32 mask;
+    std::vector<std::atomic<float>> ring;
+
+    std::atomic<uint32> numSamplesStarted, numSamplesWritten, numClears;
+    std::atomic<int> numSilentSamples;
+
+    std::atomic<float>* getChannel (int chan) noexcept               { return ring.data() + chan * capacity; }
+    const std::atomic<float>* getChannel (int chan) const noexcept   { return ring.data() + chan * capacity; }
+
+    void writeBlock (const float* const* channelData, int numChannelsIn, int numSamples) noexcept
+    {
+        // (a block bigger than the whole ring would just overwrite itself, but
+        // doing it in pieces keeps the readers' overlap check simple)
+        for (int offset = 0; offset < numSamples;)
+        {
+            const int num = jmin (numSamples - offset, capacity);
+            writeSamples (channelData, numChannelsIn, offset, num);
+            offset += num;
+        }
+    }
+
+    void writeSamples (const float* const* channelData, int numChannelsIn, int offset, int num) noexcept
+    {
+        const uint32 start = numSamplesWritten.load (std::memory_order_relaxed);
+
+        // this makes sure that any reader which sees one of the new samples will
+        // also see that we've started writing this far
+        numSamplesStarted.store (start + (uint32) num, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+        {
+            const float* source = (chan < numChannelsIn && channelData[chan] != nullptr)
+                                    ? channelData[chan] + offset : nullptr;
+            std::atomic<float>* const dest = getChannel (chan);
+
+            for (int i = 0; i < num; ++i)
+                dest[(start + (uint32) i) & mask].store (source != nullptr ? source[i] : 0.0f,
+                                                        std::memory_order_relaxed);
+        }
+
+        numSamplesWritten.store (start + (uint32) num, std::memory_order_release);
+    }
+
+    void copyRange (float* dest, int chan, uint32 start, int num) const noexcept
+    {
+        const std::atomic<float>* const source = getChannel (chan);
+
+        for (int i = 0; i < num; ++i)
+            dest[i] = source[(start + (uint32) i) & mask].load (std::memory_order_relaxed);
+    }
+
+    // Call this after copying samples from start onwards: it returns false if the
+    // writer might have started overwriting them while they were being copied.
+    bool isStillValid (uint32 start) const noexcept
+    {
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        return numSamplesStarted.load (std::memory_order_relaxed) - start <= (uint32) capacity;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (AnalysisBus)
+};
+
+
+#endif  // ANALYSISBUS_H_INCLUDED
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demos created for
+   the JUCE Summit 2015 and CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef ANIMATIONSCHEDULER_H_INCLUDED
+#define ANIMATIONSCHEDULER_H_INCLUDED
+
+// Note: the AudioDemo includes this file from inside a struct, so everything
+// in here has to be a class - no free functions or static data members!
+
+//==============================================================================
+/* A single frame clock that drives all the animated components.
+
+   Instead of every component running its own Timer at its own rate, they
+   derive from AnimationScheduler::Client and get an animationTick() call
+   from one shared timer that runs at the display's refresh rate. Each client
+   only gets ticked when its own interval has elapsed, so slower animations
+   just skip frames, and all the repaints that happen in the same frame get
+   merged into a single paint of the window.
+
+   Clients whose component isn't currently showing (hidden, or in a minimised
+   window) aren't ticked at all, and the timer stops completely when there
+   are no clients left.
+*/
+class AnimationScheduler  : private Timer
+{
+public:
+    AnimationScheduler() {}
+
+    ~AnimationScheduler()
+    {
+        jassert (clients.size() == 0);
+    }
+
+    //==========================================================================
+    class Client
+    {
+    public:
+        Client (Component& componentToAnimate, double intervalMilliseconds)
+            : component (componentToAnimate),
+              intervalMs (intervalMilliseconds),
+              nextTickTime (0.0),
+              paused (false)
+        {
+            scheduler->addClient (this);
+        }
+
+        virtual ~Client()
+        {
+            scheduler->removeClient (this);
+        }
+
+        /** Called on the message thread each time this client's interval has elapsed. */
+        virtual void animationTick() = 0;
+
+        void setAnimationInterval (double newIntervalMilliseconds) noexcept
+        {
+            intervalMs = newIntervalMilliseconds;
+        }
+
+        void pauseAnimation() noexcept       { paused = true; }
+
+        /** Resumes ticking, starting a whole interval from now. */
+        void resumeAnimation() noexcept
+        {
+            paused = false;
+            nextTickTime = Time::getMillisecondCounterHiRes() + intervalMs;
+        }
+
+    private:
+        friend class AnimationScheduler;
+
+        SharedResourcePointer<AnimationScheduler> scheduler;
+        Component& component;
+        double intervalMs, nextTickTime;
+        bool paused;
+
+        JUCE_DECLARE_NON_COPYABLE (Client)
+    };
+
+private:
+    //==========================================================================
+    void addClient (Client* client)
+    {
+        client->nextTickTime = Time::getMillisecondCounterHiRes() + client->intervalMs;
+        clients.add (client);
+
+        if (! isTimerRunning())
+            startTimerHz (displayRefreshRateHz);
+    }
+
+    void removeClient (Client* client)
+    {
+        clients.removeFirstMatchingValue (client);
+
+        if (clients.size() == 0)
+            stopTimer();
+    }
+
+    void timerCallback() override
+    {
+        const double now = Time::getMillisecondCounterHiRes();
+
+        // a client is due if its tick falls anywhere within this frame
+        const double frameEnd = now + 500.0 / displayRefreshRateHz;
+
+        for (int i = clients.size(); --i >= 0;)
+        {
+            if (Client* client = clients[i])
+            {
+                if (client->paused || client->nextTickTime > frameEnd)
+                    continue;
+
+                client->nextTickTime += client->intervalMs;
+
+                // if we've fallen more than a whole interval behind, don't try to catch up
+                if (client->nextTickTime < now)
+                    client->nextTickTime = now + client->intervalMs;
+
+                if (client->component.isShowing())
+                    client->animationTick();
+            }
+        }
+    }
+
+    //==========================================================================
+    Array<Client*> clients;
+
+    // JUCE doesn't tell us the real refresh rate of the display, but this is
+    // what nearly all of them run at.
+    const int displayRefreshRateHz = 60;
+
+    JUCE_DECLARE_NON_COPYABLE (AnimationScheduler)
+};
+
+
+#endif  // ANIMATIONSCHEDULER_H_INCLUDED
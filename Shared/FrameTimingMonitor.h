@@ -0,0 +1,252 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demos created for
+   the JUCE Summit 2015 and CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef FRAMETIMINGMONITOR_H_INCLUDED
+#define FRAMETIMINGMONITOR_H_INCLUDED
+
+// Note: the AudioDemo includes this file from inside a struct, so everything
+// in here has to be a class - no free functions or static data members!
+
+#include "AnimationScheduler.h"
+
+class FrameTimingMonitor;
+
+//==============================================================================
+/* Keeps track of all the FrameTimingMonitors that currently exist.
+   Use it through a SharedResourcePointer.
+*/
+class FrameTimingRegistry
+{
+public:
+    FrameTimingRegistry() {}
+
+    void add (FrameTimingMonitor* monitor)
+    {
+        const ScopedLock sl (lock);
+        monitors.addIfNotAlreadyThere (monitor);
+    }
+
+    void remove (FrameTimingMonitor* monitor)
+    {
+        const ScopedLock sl (lock);
+        monitors.removeFirstMatchingValue (monitor);
+    }
+
+    /** Calls the function for each registered monitor, while holding the lock. */
+    template <typename FunctionType>
+    void forEach (FunctionType function) const
+    {
+        const ScopedLock sl (lock);
+
+        for (auto* m : monitors)
+            function (*m);
+    }
+
+private:
+    CriticalSection lock;
+    Array<FrameTimingMonitor*> monitors;
+
+    JUCE_DECLARE_NON_COPYABLE (FrameTimingRegistry)
+};
+
+//==============================================================================
+/* Records how long a Timer-driven component takes to paint, how regularly
+   its timer fires, and how many frames it misses.
+
+   Call timerTicked() at the start of the component's timer or animation
+   callback, and create a ScopedPaint at the top of its paint() method.
+*/
+class FrameTimingMonitor
+{
+public:
+    FrameTimingMonitor (const String& componentName, double expectedIntervalMilliseconds)
+        : name (componentName), expectedIntervalMs (expectedIntervalMilliseconds), lastTickTime (0.0)
+    {
+        registry->add (this);
+    }
+
+    ~FrameTimingMonitor()
+    {
+        registry->remove (this);
+    }
+
+    //==========================================================================
+    struct Stats
+    {
+        int64 numTicks = 0, numPaints = 0, numDroppedFrames = 0, numOverBudgetPaints = 0;
+        double averagePaintMs = 0, maxPaintMs = 0;
+        double averageJitterMs = 0, maxJitterMs = 0;
+    };
+
+    void timerTicked() noexcept
+    {
+        const double now = Time::getMillisecondCounterHiRes();
+        const SpinLock::ScopedLockType sl (statsLock);
+
+        if (lastTickTime > 0)
+        {
+            const double interval = now - lastTickTime;
+            const double jitter = std::abs (interval - expectedIntervalMs);
+
+            stats.averageJitterMs += smoothing * (jitter - stats.averageJitterMs);
+            stats.maxJitterMs = jmax (stats.maxJitterMs, jitter);
+
+            // any whole intervals that went by without a tick are frames we never drew
+            stats.numDroppedFrames += jmax ((int64) 0, (int64) (interval / expectedIntervalMs + 0.5) - 1);
+        }
+
+        lastTickTime = now;
+        ++stats.numTicks;
+    }
+
+    void paintFinished (double paintDurationMs) noexcept
+    {
+        const SpinLock::ScopedLockType sl (statsLock);
+
+        stats.averagePaintMs += smoothing * (paintDurationMs - stats.averagePaintMs);
+        stats.maxPaintMs = jmax (stats.maxPaintMs, paintDurationMs);
+        ++stats.numPaints;
+
+        if (paintDurationMs > expectedIntervalMs)
+            ++stats.numOverBudgetPaints;
+    }
+
+    Stats getStats() const noexcept
+    {
+        const SpinLock::ScopedLockType sl (statsLock);
+        return stats;
+    }
+
+    const String& getName() const noexcept               { return name; }
+    double getExpectedIntervalMs() const noexcept        { return expectedIntervalMs; }
+
+    /** Returns the current stats of all the monitors as a JSON array. */
+    static String createJSONDump()
+    {
+        Array<var> list;
+
+        SharedResourcePointer<FrameTimingRegistry>()->forEach ([&list] (const FrameTimingMonitor& m)
+        {
+            const Stats stats (m.getStats());
+
+            DynamicObject* o = new DynamicObject();
+            o->setProperty ("name",                m.getName());
+            o->setProperty ("expectedIntervalMs",  m.getExpectedIntervalMs());
+            o->setProperty ("ticks",               stats.numTicks);
+            o->setProperty ("paints",              stats.numPaints);
+            o->setProperty ("droppedFrames",       stats.numDroppedFrames);
+            o->setProperty ("overBudgetPaints",    stats.numOverBudgetPaints);
+            o->setProperty ("averagePaintMs",      stats.averagePaintMs);
+            o->setProperty ("maxPaintMs",          stats.maxPaintMs);
+            o->setProperty ("averageJitterMs",     stats.averageJitterMs);
+            o->setProperty ("maxJitterMs",         stats.maxJitterMs);
+
+            list.add (var (o));
+        });
+
+        return JSON::toString (var (list));
+    }
+
+    //==========================================================================
+    struct ScopedPaint
+    {
+        ScopedPaint (FrameTimingMonitor& m) noexcept
+            : monitor (m), startTime (Time::getMillisecondCounterHiRes())
+        {
+        }
+
+        ~ScopedPaint()
+        {
+            monitor.paintFinished (Time::getMillisecondCounterHiRes() - startTime);
+        }
+
+        FrameTimingMonitor& monitor;
+        const double startTime;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedPaint)
+    };
+
+private:
+    //==========================================================================
+    SharedResourcePointer<FrameTimingRegistry> registry;
+
+    const String name;
+    const double expectedIntervalMs;
+    const double smoothing = 0.05;
+
+    SpinLock statsLock;
+    Stats stats;
+    double lastTickTime;
+
+    JUCE_DECLARE_NON_COPYABLE (FrameTimingMonitor)
+};
+
+//==============================================================================
+/* A see-through panel that shows the stats of every FrameTimingMonitor.
+   Put it on top of your other components - it ignores the mouse.
+*/
+class FrameTimingOverlay  : public Component,
+                            private AnimationScheduler::Client
+{
+public:
+    FrameTimingOverlay()
+        : AnimationScheduler::Client (*this, 250.0)
+    {
+        setInterceptsMouseClicks (false, false);
+    }
+
+    void paint (Graphics& g) override
+    {
+        StringArray lines;
+        lines.add ("component          paint avg/max   jitter avg/max   dropped  slow");
+
+        registry->forEach ([&lines] (const FrameTimingMonitor& m)
+        {
+            const FrameTimingMonitor::Stats stats (m.getStats());
+
+            lines.add (m.getName().substring (0, 18).paddedRight (' ', 19)
+                        + (String (stats.averagePaintMs, 1) + "/" + String (stats.maxPaintMs, 1)).paddedRight (' ', 16)
+                        + (String (stats.averageJitterMs, 1) + "/" + String (stats.maxJitterMs, 1)).paddedRight (' ', 17)
+                        + String (stats.numDroppedFrames).paddedRight (' ', 9)
+                        + String (stats.numOverBudgetPaints));
+        });
+
+        const Font font (Font::getDefaultMonospacedFontName(), 11.0f, Font::plain);
+        const int lineHeight = roundToInt (font.getHeight());
+
+        g.setColour (Colours::black.withAlpha (0.6f));
+        g.fillRect (getLocalBounds().withHeight (lineHeight * lines.size() + 8));
+
+        g.setFont (font);
+        g.setColour (Colours::white);
+
+        for (int i = 0; i < lines.size(); ++i)
+            g.drawSingleLineText (lines[i], 4, 4 + lineHeight * (i + 1) - 2);
+    }
+
+private:
+    void animationTick() override
+    {
+        repaint();
+    }
+
+    SharedResourcePointer<FrameTimingRegistry> registry;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameTimingOverlay)
+};
+
+
+#endif  // FRAMETIMINGMONITOR_H_INCLUDED
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+   This file is part of the Projucer live coding demos created for
+   the JUCE Summit 2015 and CppCon 2015.
+   Copyright (c) 2015 - ROLI Ltd.
+
+   Use this code at your own risk & have some fun with C++ live coding!
+
+   This code is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.
+
+  ==============================================================================
+*/
+
+#ifndef PARAMETERSTORE_H_INCLUDED
+#define PARAMETERSTORE_H_INCLUDED
+
+// Note: the AudioDemo includes this file from inside a struct, so everything
+// in here has to be a class - no free functions or static data members!
+// (it also means <atomic> has to be included before that struct)
+
+#include <atomic>
+
+//==============================================================================
+/* A single float parameter that the UI thread sets and the audio thread reads.
+   Both sides are just a relaxed atomic load or store, so neither of them can
+   ever block the other.
+*/
+class AtomicParameter
+{
+public:
+    AtomicParameter (const String& parameterID, float minimum, float maximum, float defaultValue)
+        : paramID (parameterID), minValue (minimum), maxValue (maximum),
+          value (jlimit (minimum, maximum, defaultValue))
+    {
+    }
+
+    /** Can be called from any thread. The value is clipped to the parameter's range. */
+    void set (float newValue) noexcept
+    {
+        value.store (jlimit (minValue, maxValue, newValue), std::memory_order_relaxed);
+    }
+
+    /** Can be called from any thread. */
+    float get() const noexcept
+    {
+        return value.load (std::memory_order_relaxed);
+    }
+
+    const String& getID() const noexcept    { return paramID; }
+    float getMinimum() const noexcept       { return minValue; }
+    float getMaximum() const noexcept       { return maxValue; }
+
+private:
+    const String paramID;
+    const float minValue, maxValue;
+    std::atomic<float> value;
+
+    JUCE_DECLARE_NON_COPYABLE (AtomicParameter)
+};
+
+//==============================================================================
+/* Passes whole snapshots of some compound state from one writer thread to
+   one reader thread, without locks.
+
+   This is a triple buffer: the writer fills in its own copy and swaps it
+   into the middle slot, and the reader swaps the middle slot out when there
+   is something new in it. Neither side ever waits, and the reader always
+   gets a complete, consistent snapshot - the most recent one.
+
+   StateType should be a plain struct with no heap-allocated members, so
+   that copying it is safe on the audio thread.
+*/
+template <typename StateType>
+class SnapshotExchange
+{
+public:
+    SnapshotExchange()
+        : middle (1), writeIndex (0), readIndex (2)
+    {
+    }
+
+    SnapshotExchange (const StateType& initialState)
+        : SnapshotExchange()
+    {
+        for (auto& b : buffers)
+            b = initialState;
+    }
+
+    //==========================================================================
+    /** Writer side: publishes a new snapshot. */
+    void push (const StateType& newState) noexcept
+    {
+        buffers[writeIndex] = newState;
+        writeIndex = middle.exchange (writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Reader side: if there's a snapshot newer than the last one pulled, copies it
+        into dest and returns true. Otherwise returns false and leaves dest alone.
+    */
+    bool pull (StateType& dest) noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & newDataFlag) == 0)
+            return false;
+
+        readIndex = middle.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+        dest = buffers[readIndex];
+        return true;
+    }
+
+private:
+    //==========================================================================
+    enum { indexMask = 3, newDataFlag = 4 };
+
+    StateType buffers[3];
+    std::atomic<int> middle;
+    int writeIndex, readIndex;
+
+    JUCE_DECLARE_NON_COPYABLE (SnapshotExchange)
+};
+
+//==============================================================================
+/* A set of AtomicParameters that can be looked up by ID.
+
+   Parameters should all be added before the audio starts. After that, the
+   audio thread should hang on to references to the parameters it needs rather
+   than looking them up by name every block.
+*/
+class ParameterStore
+{
+public:
+    ParameterStore() {}
+
+    AtomicParameter& add (const String& parameterID, float minimum, float maximum, float defaultValue)
+    {
+        jassert (get (parameterID) == nullptr); // IDs must be unique!
+        return *parameters.add (new AtomicParameter (parameterID, minimum, maximum, defaultValue));
+    }
+
+    AtomicParameter* get (const String& parameterID) const noexcept
+    {
+        for (auto* p : parameters)
+            if (p->getID() == parameterID)
+                return p;
+
+        return nullptr;
+    }
+
+    int size() const noexcept                           { return parameters.size(); }
+    AtomicParameter& operator[] (int index) const       { return *parameters.getUnchecked (index); }
+
+private:
+    OwnedArray<AtomicParameter> parameters;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterStore)
+};
+
+
+#endif  // PARAMETERSTORE_H_INCLUDED